@@ -48,10 +48,16 @@ class Classifier {
   Classifier() {}
   virtual ~Classifier() {}
 
-  virtual void SetFeatureMap(seeta::fd::FeatureMap* feat_map) = 0;
-  virtual bool Classify(float* score = nullptr, float* outputs = nullptr) = 0;
-  
-  virtual seeta::fd::ClassifierType type() = 0;
+  /**
+   * @brief Classify the current ROI of the given feature map.
+   *
+   * Classifiers are read-only once loaded, so one instance can be shared by
+   * any number of threads as long as each passes its own feature map.
+   */
+  virtual bool Classify(seeta::fd::FeatureMap* feat_map,
+    float* score = nullptr, float* outputs = nullptr) const = 0;
+
+  virtual seeta::fd::ClassifierType type() const = 0;
 
   DISABLE_COPY_AND_ASSIGN(Classifier);
 };
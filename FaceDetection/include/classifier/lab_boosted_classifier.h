@@ -44,65 +44,155 @@ namespace seeta {
 namespace fd {
 
 /**
- * @class LABBaseClassifier
- * @brief Base classifier using LAB feature.
+ * @class LABModelTable
+ * @brief Parameters of all base classifiers of a LAB boosted classifier,
+ *        laid out in one contiguous block.
+ *
+ * The block holds the thresholds, the feature positions and a
+ * `num_base x weight_stride()` weight table, each section starting on a
+ * 64-byte boundary. An int16 fixed-point copy of the weights and thresholds
+ * can be built on demand to halve the footprint of the weight table.
  */
-class LABBaseClassifier {
+class LABModelTable {
  public:
-  LABBaseClassifier()
-    : num_bin_(255), thresh_(0.0f) {
-    weights_.resize(num_bin_ + 1);
-  }
+  LABModelTable()
+      : num_base_(0), num_bin_(0), weight_stride_(0), scale_(1.0f),
+        thresh_(nullptr), feat_(nullptr), weights_(nullptr),
+        thresh_int16_(nullptr), weights_int16_(nullptr) {}
+  ~LABModelTable() {}
+
+  /** Allocate the table for the given number of base classifiers and bins */
+  void Reset(int32_t num_base, int32_t num_bin);
+
+  /**
+   * @brief Build the int16 weights and the matching thresholds.
+   *
+   * Weights are scaled by `scale()` so that the largest one maps to 32767.
+   * Sums of the scaled weights stay exact in float, so the fixed-point path
+   * only differs from the float one by the rounding of the weights.
+   */
+  void Quantize();
+
+  inline int32_t num_base() const { return num_base_; }
+  inline int32_t num_bin() const { return num_bin_; }
+  inline int32_t weight_stride() const { return weight_stride_; }
+  inline float scale() const { return scale_; }
+  inline bool is_quantized() const { return weights_int16_ != nullptr; }
 
-  ~LABBaseClassifier() {}
+  inline float* thresh() { return thresh_; }
+  inline const float* thresh() const { return thresh_; }
+  inline seeta::fd::LABFeature* feat() { return feat_; }
+  inline const seeta::fd::LABFeature* feat() const { return feat_; }
+  inline float* weights() { return weights_; }
+  inline const float* weights() const { return weights_; }
 
-  void SetWeights(const float* weights, int32_t num_bin);
+  /** Thresholds in the scaled domain, stored as (integral) floats */
+  inline const float* thresh_int16() const { return thresh_int16_; }
+  inline const int16_t* weights_int16() const { return weights_int16_; }
 
-  inline void SetThreshold(float thresh) { thresh_ = thresh; }
+ private:
+  static const int32_t kAlignment = 64;
 
-  inline int32_t num_bin() const { return num_bin_; }
-  inline float weights(int32_t val) const { return weights_[val]; }
-  inline float threshold() const { return thresh_; }
+  static uint8_t* AlignedBuffer(std::vector<uint8_t>* buf, size_t len);
+  static inline size_t AlignSize(size_t len) {
+    return (len + kAlignment - 1) / kAlignment * kAlignment;
+  }
 
- private:
+  int32_t num_base_;
   int32_t num_bin_;
+  int32_t weight_stride_;
+  float scale_;
 
-  std::vector<float> weights_;
-  float thresh_;
+  std::vector<uint8_t> buf_;
+  float* thresh_;
+  seeta::fd::LABFeature* feat_;
+  float* weights_;
+
+  std::vector<uint8_t> buf_int16_;
+  float* thresh_int16_;
+  int16_t* weights_int16_;
+
+  DISABLE_COPY_AND_ASSIGN(LABModelTable);
 };
 
 /**
  * @class LABBoostedClassifier
  * @Brief A strong classifier constructed from base classifiers using LAB features.
  */
-class LABBoostedClassifier : public Classifier {
+class LABBoostedClassifier final : public Classifier {
  public:
-  LABBoostedClassifier() : use_std_dev_(true) {}
+  LABBoostedClassifier() : use_std_dev_(true), use_int16_(false) {}
   virtual ~LABBoostedClassifier() {}
 
-  virtual bool Classify(float* score = nullptr, float* outputs = nullptr);
-
-  inline virtual seeta::fd::ClassifierType type() {
+  virtual bool Classify(seeta::fd::FeatureMap* feat_map,
+    float* score = nullptr, float* outputs = nullptr) const;
+
+  /**
+   * @brief Classify a set of windows of size `wnd_size`, whose top left
+   *        corners lie at offsets `wnd_offset` of the feature map.
+   *
+   * Windows go through the base classifiers in lockstep, 8 (AVX2) or 16
+   * (AVX-512) at a time on CPUs supporting them. After each group of
+   * `kFeatGroupSize` base classifiers the rejected windows are dropped and
+   * the survivors compacted, so that vectors stay full. Scores are the same as
+   * those of `Classify()`.
+   *
+   * @param wnd_idx receives the indices of the positive windows in increasing
+   *        order, with their scores in `wnd_score`; both need `num_wnd` slots.
+   * @return the number of positive windows
+   */
+  int32_t Classify(const seeta::fd::LABFeatureMap* feat_map,
+    const int32_t* wnd_offset, int32_t num_wnd, int32_t wnd_size,
+    int32_t* wnd_idx, float* wnd_score) const;
+
+  /**
+   * @brief Same as above, over the first `num_base` base classifiers only
+   *        and with thresholds lowered by `margin`.
+   *
+   * A cheap and loose test telling where windows are worth scanning, used by
+   * the coarse-to-fine search. `num_base` is rounded up to a whole group and
+   * the std dev of windows is not checked.
+   */
+  int32_t Probe(const seeta::fd::LABFeatureMap* feat_map,
+    const int32_t* wnd_offset, int32_t num_wnd, int32_t num_base, float margin,
+    int32_t* wnd_idx, float* wnd_score) const;
+
+  inline virtual seeta::fd::ClassifierType type() const {
     return seeta::fd::ClassifierType::LAB_Boosted_Classifier;
   }
 
-  void AddFeature(int32_t x, int32_t y);
-  void AddBaseClassifier(const float* weights, int32_t num_bin, float thresh);
-
-  inline virtual void SetFeatureMap(seeta::fd::FeatureMap* featMap) {
-    feat_map_ = dynamic_cast<seeta::fd::LABFeatureMap*>(featMap);
-  }
+  /** Table filled in by the model reader */
+  inline seeta::fd::LABModelTable* table() { return &table_; }
 
   inline void SetUseStdDev(bool useStdDev) { use_std_dev_ = useStdDev; }
 
+  /**
+   * @brief Evaluate with the int16 weights instead of the float ones.
+   *
+   * Scores may differ slightly from the float ones; see
+   * `LABModelTable::Quantize()`.
+   */
+  void SetUseInt16Weights(bool use);
+
  private:
+  /** Score of the current ROI, over all base classifiers it passes */
+  template<typename WeightType>
+  bool ClassifyWindow(const seeta::fd::LABFeatureMap* feat_map,
+    const WeightType* weights, const float* thresh, float* score) const;
+
+  /** Run the first `num_base` base classifiers, lowering thresholds by `margin` */
+  template<typename WeightType>
+  int32_t Classify(const seeta::fd::LABFeatureMap* feat_map,
+    const WeightType* weights, const float* thresh, int32_t num_base,
+    float margin, const int32_t* wnd_offset, int32_t num_wnd, int32_t* wnd_idx,
+    float* wnd_score) const;
+
   static const int32_t kFeatGroupSize = 10;
   const float kStdDevThresh = 10.0f;
 
-  std::vector<seeta::fd::LABFeature> feat_;
-  std::vector<std::shared_ptr<seeta::fd::LABBaseClassifier> > base_classifiers_;
-  seeta::fd::LABFeatureMap* feat_map_;
+  seeta::fd::LABModelTable table_;
   bool use_std_dev_;
+  bool use_int16_;
 };
 
 }  // namespace fd
@@ -38,6 +38,7 @@
 #include <algorithm>
 #include <vector>
 
+#include "executor.h"
 #include "util/math_func.h"
 
 namespace seeta {
@@ -49,11 +50,59 @@ class MLPLayer {
       : input_dim_(0), output_dim_(0), act_func_type_(act_func_type) {}
   ~MLPLayer() {}
 
-  void Compute(const float* input, float* output);
+  /**
+   * @brief Compute the outputs of a single input, splitting the outputs over
+   *        `executor` when not nullptr.
+   */
+  void Compute(const float* input, float* output,
+    seeta::Executor* executor = nullptr) const;
+
+  /**
+   * @brief Compute the outputs of `num` inputs at once.
+   *
+   * `input` is a `num` x `input_dim` row-major matrix and `output` receives
+   * the `num` x `output_dim` one. Each weight row is loaded once for a block
+   * of inputs, with the bias and the activation applied on the fly. Outputs
+   * equal those of the single-input `Compute()`.
+   */
+  void Compute(const float* input, float* output, int32_t num) const;
+
+  /**
+   * @brief Compute the outputs of an input split into `num_part` parts.
+   *
+   * The i-th part holds `part_dim[i]` values at `input[i]` and is read in
+   * place, so the parts need not be copied into one vector beforehand.
+   */
+  void Compute(const float* const* input, const int32_t* part_dim,
+    int32_t num_part, float* output) const;
+
+  /**
+   * @brief Batch `Compute()` with the int8 weights built by `Quantize()`.
+   *
+   * Each input row is quantized to int16 with a scale of its own, which
+   * takes `num * GetPaddedInputDim()` values of `input_buf` and `num` of
+   * `input_scale`, and the products are accumulated in int32.
+   */
+  void ComputeInt8(const float* input, float* output, int32_t num,
+    int16_t* input_buf, float* input_scale) const;
+
+  /**
+   * @brief Build int8 weights, with one scale for each output.
+   *
+   * Rows are zero-padded to `GetPaddedInputDim()` values.
+   */
+  void Quantize();
+
+  inline bool is_quantized() const { return !weights_int8_.empty(); }
 
   inline int32_t GetInputDim() const { return input_dim_; }
   inline int32_t GetOutputDim() const { return output_dim_; }
 
+  /** Input dim rounded up to the width of the int8 kernels */
+  inline int32_t GetPaddedInputDim() const {
+    return (input_dim_ + kInt8Width - 1) / kInt8Width * kInt8Width;
+  }
+
   inline void SetSize(int32_t inputDim, int32_t outputDim) {
     if (inputDim <= 0 || outputDim <= 0) {
       return;  // @todo handle the errors!!!
@@ -62,6 +111,7 @@ class MLPLayer {
     output_dim_ = outputDim;
     weights_.resize(inputDim * outputDim);
     bias_.resize(outputDim);
+    weights_int8_.clear();
   }
 
   inline void SetWeights(const float* weights, int32_t len) {
@@ -69,6 +119,7 @@ class MLPLayer {
       return;  // @todo handle the errors!!!
     }
     std::copy(weights, weights + input_dim_ * output_dim_, weights_.begin());
+    weights_int8_.clear();
   }
 
   inline void SetBias(const float* bias, int32_t len) {
@@ -79,29 +130,61 @@ class MLPLayer {
   }
 
  private:
-  inline float Sigmoid(float x) {
+  inline float Sigmoid(float x) const {
     return 1.0f / (1.0f + std::exp(x));
   }
 
-  inline float ReLU(float x) {
+  inline float ReLU(float x) const {
     return (x > 0.0f ? x : 0.0f);
   }
 
+  inline float Activate(float x) const {
+    return (act_func_type_ == 1 ? ReLU(x) : Sigmoid(-x));
+  }
+
  private:
+  static const int32_t kInt8Width = 16;
+
   int32_t act_func_type_;
   int32_t input_dim_;
   int32_t output_dim_;
   std::vector<float> weights_;
   std::vector<float> bias_;
+
+  std::vector<int8_t> weights_int8_;
+  std::vector<float> weight_scale_;  /**< scale of each weight row */
 };
 
 
 class MLP {
  public:
-  MLP() {}
+  MLP() : buf_size_(0), quant_buf_size_(0), use_int8_(false) {}
   ~MLP() {}
 
-  void Compute(const float* input, float* output);
+  /**
+   * @brief Run all layers on `input`.
+   *
+   * `buf` provides room for the hidden layer outputs and should hold at least
+   * `GetBufferSize()` floats. The layers run on `executor` when not nullptr.
+   */
+  void Compute(const float* input, float* output, float* buf,
+    seeta::Executor* executor = nullptr) const;
+
+  /**
+   * @brief Run all layers on `num` inputs stored as rows of `input`.
+   *
+   * `buf` should hold at least `num * GetBufferSize()` floats.
+   */
+  void Compute(const float* input, float* output, int32_t num,
+    float* buf) const;
+
+  /**
+   * @brief Run all layers on an input split into parts, see
+   * `MLPLayer::Compute()`.
+   */
+  void Compute(const float* const* input, const int32_t* part_dim,
+    int32_t num_part, float* output, float* buf,
+    seeta::Executor* executor = nullptr) const;
 
   inline int32_t GetInputDim() const {
     return layers_[0]->GetInputDim();
@@ -115,12 +198,26 @@ class MLP {
     return static_cast<int32_t>(layers_.size());
   }
 
+  inline int32_t GetBufferSize() const {
+    return buf_size_ + quant_buf_size_;
+  }
+
+  /**
+   * @brief Run the batch `Compute()` with int8 weights.
+   *
+   * Outputs may differ slightly from the float ones; see
+   * `MLPLayer::ComputeInt8()`. The single-input paths keep float weights.
+   */
+  void SetUseInt8Weights(bool use);
+
   void AddLayer(int32_t inputDim, int32_t outputDim, const float* weights,
       const float* bias, bool is_output = false);
 
  private:
   std::vector<std::shared_ptr<seeta::fd::MLPLayer> > layers_;
-  std::vector<float> layer_buf_[2];
+  int32_t buf_size_; /**< twice the largest hidden layer output dim */
+  int32_t quant_buf_size_; /**< floats taken by a quantized input row */
+  bool use_int8_;
 };
 
 }  // namespace fd
@@ -42,18 +42,34 @@
 namespace seeta {
 namespace fd {
 
-class SURFMLP : public Classifier {
+class SURFMLP final : public Classifier {
  public:
   SURFMLP() : Classifier(), model_(new seeta::fd::MLP()) {}
   virtual ~SURFMLP() {}
 
-  virtual bool Classify(float* score = nullptr, float* outputs = nullptr);
+  virtual bool Classify(seeta::fd::FeatureMap* feat_map,
+    float* score = nullptr, float* outputs = nullptr) const;
 
-  inline virtual void SetFeatureMap(seeta::fd::FeatureMap* feat_map) {
-    feat_map_ = dynamic_cast<seeta::fd::SURFFeatureMap*>(feat_map);
-  }
+  /**
+   * @brief Classify `num` windows whose feature vectors are the rows of
+   * `input`, as given by `GetFeatureVector()`.
+   *
+   * The `num` x `GetOutputDim()` network outputs are written to `outputs`,
+   * whose first column holds the scores. `buf` should hold at least
+   * `num * GetBufferSize()` floats.
+   */
+  void Classify(const float* input, int32_t num, float* outputs,
+    float* buf) const;
+
+  /** Copy the `GetInputDim()` features of the current window to `feat`. */
+  void GetFeatureVector(seeta::fd::FeatureMap* feat_map, float* feat) const;
 
-  inline virtual seeta::fd::ClassifierType type() {
+  inline int32_t GetInputDim() const { return model_->GetInputDim(); }
+  inline int32_t GetOutputDim() const { return model_->GetOutputDim(); }
+  inline int32_t GetBufferSize() const { return model_->GetBufferSize(); }
+  inline float threshold() const { return thresh_; }
+
+  inline virtual seeta::fd::ClassifierType type() const {
     return seeta::fd::ClassifierType::SURF_MLP;
   }
 
@@ -63,14 +79,19 @@ class SURFMLP : public Classifier {
 
   inline void SetThreshold(float thresh) { thresh_ = thresh; }
 
+  /**
+   * @brief Run the batch `Classify()` with int8 weights.
+   *
+   * Scores may differ slightly from the float ones; see
+   * `MLPLayer::ComputeInt8()`.
+   */
+  inline void SetUseInt8Weights(bool use) { model_->SetUseInt8Weights(use); }
+
  private:
   std::vector<int32_t> feat_id_;
-  std::vector<float> input_buf_;
-  std::vector<float> output_buf_;
 
   std::shared_ptr<seeta::fd::MLP> model_;
   float thresh_;
-  seeta::fd::SURFFeatureMap* feat_map_;
 };
 
 }  // namespace fd
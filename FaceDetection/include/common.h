@@ -50,12 +50,6 @@
   classname(const classname&); \
   classname& operator=(const classname&)
 
-#ifdef USE_OPENMP
-#include <omp.h>
-
-#define SEETA_NUM_THREADS 4
-#endif
-
 namespace seeta {
 
 	typedef struct ImageData {
@@ -64,6 +58,7 @@ namespace seeta {
 			width = 0;
 			height = 0;
 			num_channels = 0;
+			stride = 0;
 		}
 
 		ImageData(int32_t img_width, int32_t img_height,
@@ -72,12 +67,19 @@ namespace seeta {
 			width = img_width;
 			height = img_height;
 			num_channels = img_num_channels;
+			stride = 0;
+		}
+
+		/** Bytes from the start of a row to that of the next one */
+		inline int32_t GetStride() const {
+			return (stride > 0 ? stride : width * num_channels);
 		}
 
 		uint8_t* data;					// ͼƬ
 		int32_t width;					// ͼƬ
 		int32_t height;					// ͼƬ߶
 		int32_t num_channels;				// ͨ
+		int32_t stride;					// row pitch in bytes, 0 for width * num_channels
 	} ImageData;
 
 	typedef struct Rect {
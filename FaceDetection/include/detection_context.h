@@ -0,0 +1,203 @@
+/*
+ *
+ * This file is part of the open-source SeetaFace engine, which includes three modules:
+ * SeetaFace Detection, SeetaFace Alignment, and SeetaFace Identification.
+ *
+ * This file is part of the SeetaFace Detection module, containing codes implementing the
+ * face detection method described in the following paper:
+ *
+ *
+ *   Funnel-structured cascade for multi-view face detection with alignment awareness,
+ *   Shuzhe Wu, Meina Kan, Zhenliang He, Shiguang Shan, Xilin Chen.
+ *   In Neurocomputing (under review)
+ *
+ *
+ * Copyright (C) 2016, Visual Information Processing and Learning (VIPL) group,
+ * Institute of Computing Technology, Chinese Academy of Sciences, Beijing, China.
+ *
+ * The codes are mainly developed by Shuzhe Wu (a Ph.D supervised by Prof. Shiguang Shan)
+ *
+ * As an open-source face recognition engine: you can redistribute SeetaFace source codes
+ * and/or modify it under the terms of the BSD 2-Clause License.
+ *
+ * You should have received a copy of the BSD 2-Clause License along with the software.
+ * If not, see < https://opensource.org/licenses/BSD-2-Clause>.
+ *
+ * Contact Info: you can send an email to SeetaFace@vipl.ict.ac.cn for any problems.
+ *
+ * Note: the above information must be kept whenever or wherever the codes are used.
+ *
+ */
+
+
+#ifndef SEETA_FD_DETECTION_CONTEXT_H_
+#define SEETA_FD_DETECTION_CONTEXT_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "common.h"
+#include "executor.h"
+#include "feature_map.h"
+#include "util/image_pyramid.h"
+
+namespace seeta {
+namespace fd {
+
+/**
+ * @class DetectionContext
+ * @brief Per-call state of a detector.
+ *
+ * A loaded detector is read-only and can be shared among threads; everything
+ * written while detecting (image pyramid, feature maps, window buffers) lives
+ * here instead. A context must not be used by two threads at the same time,
+ * but it can be reused across calls to avoid reallocation.
+ */
+class DetectionContext {
+ public:
+  DetectionContext()
+      : wnd_size_(40), slide_wnd_step_x_(4), slide_wnd_step_y_(4),
+        coarse_wnd_step_(0), tile_memory_limit_(0), executor_(nullptr) {}
+  ~DetectionContext() {}
+
+  inline void SetWindowSize(int32_t size) {
+    if (size >= 20)
+      wnd_size_ = size;
+  }
+
+  inline void SetSlideWindowStep(int32_t step_x, int32_t step_y) {
+    if (step_x > 0)
+      slide_wnd_step_x_ = step_x;
+    if (step_y > 0)
+      slide_wnd_step_y_ = step_y;
+  }
+
+  /**
+   * @brief Set the step of the coarse grid probed before scanning, see
+   *        `FaceDetection::SetCoarseWindowStep()`. Zero turns it off.
+   */
+  inline void SetCoarseWindowStep(int32_t step) {
+    coarse_wnd_step_ = (step > 0 ? step : 0);
+  }
+
+  /**
+   * @brief Set the memory the sliding window may use for a tile of a level,
+   *        see `FaceDetection::SetTileMemoryLimit()`. Zero turns tiling off.
+   */
+  inline void SetTileMemoryLimit(int64_t bytes) {
+    tile_memory_limit_ = (bytes > 0 ? bytes : 0);
+  }
+
+  inline int32_t wnd_size() const { return wnd_size_; }
+  inline int32_t slide_wnd_step_x() const { return slide_wnd_step_x_; }
+  inline int32_t slide_wnd_step_y() const { return slide_wnd_step_y_; }
+  inline int32_t coarse_wnd_step() const { return coarse_wnd_step_; }
+  inline int64_t tile_memory_limit() const { return tile_memory_limit_; }
+
+  inline seeta::fd::ImagePyramid* img_pyramid() { return &img_pyramid_; }
+
+  inline void AddFeatureMap(const std::shared_ptr<seeta::fd::FeatureMap> & feat_map) {
+    feat_map->SetExecutor(executor_);
+    feat_map_.push_back(feat_map);
+  }
+
+  /**
+   * @brief Set the executor of the loops run with this context, nullptr (the
+   *        default) to run them on the calling thread.
+   *
+   * Contexts used from inside the tasks of an executor keep nullptr, so that
+   * tasks do not fork again.
+   */
+  inline void SetExecutor(seeta::Executor* executor) {
+    executor_ = executor;
+    for (size_t i = 0; i < feat_map_.size(); i++)
+      feat_map_[i]->SetExecutor(executor);
+  }
+
+  inline seeta::Executor* executor() const { return executor_; }
+
+  inline seeta::fd::FeatureMap* feat_map(int32_t idx) {
+    return feat_map_[idx].get();
+  }
+
+  inline std::vector<uint8_t>* wnd_data_buf() { return &wnd_data_buf_; }
+  inline std::vector<uint8_t>* wnd_data() { return &wnd_data_; }
+
+  /** Part of a pyramid level scanned by the sliding window */
+  inline std::vector<uint8_t>* img_crop_buf() { return &img_crop_buf_; }
+
+  /** Resizer of the parts of levels not built in the image pyramid */
+  inline seeta::fd::ImageResizer* resizer() { return &resizer_; }
+
+  /** Windows of a range left to scan by the coarse-to-fine search */
+  inline std::vector<uint8_t>* wnd_flag_buf() { return &wnd_flag_buf_; }
+
+  /** Feature matrix, network outputs and hidden layer buffer of a batch */
+  inline std::vector<float>* mlp_input_buf() { return &mlp_input_buf_; }
+  inline std::vector<float>* mlp_output_buf() { return &mlp_output_buf_; }
+  inline std::vector<float>* mlp_layer_buf() { return &mlp_layer_buf_; }
+
+  /**
+   * Measured time in microseconds to classify a window with each model, used
+   * to fit the later stages into a time budget. Zero until measured.
+   */
+  inline std::vector<float>* wnd_cost() { return &wnd_cost_; }
+
+  /**
+   * Measured number of windows classified by each model per call. Later
+   * models only see the windows passing the earlier ones, so their share of
+   * the remaining time is weighted by the ratio of these counts.
+   */
+  inline std::vector<float>* wnd_count() { return &wnd_count_; }
+
+ private:
+  int32_t wnd_size_;
+  int32_t slide_wnd_step_x_;
+  int32_t slide_wnd_step_y_;
+  int32_t coarse_wnd_step_;
+  int64_t tile_memory_limit_;
+  seeta::Executor* executor_;
+
+  seeta::fd::ImagePyramid img_pyramid_;
+  std::vector<std::shared_ptr<seeta::fd::FeatureMap> > feat_map_;
+
+  std::vector<uint8_t> wnd_data_buf_;
+  std::vector<uint8_t> wnd_data_;
+  std::vector<uint8_t> img_crop_buf_;
+  std::vector<uint8_t> wnd_flag_buf_;
+  seeta::fd::ImageResizer resizer_;
+
+  std::vector<float> mlp_input_buf_;
+  std::vector<float> mlp_output_buf_;
+  std::vector<float> mlp_layer_buf_;
+
+  std::vector<float> wnd_cost_;
+  std::vector<float> wnd_count_;
+
+  DISABLE_COPY_AND_ASSIGN(DetectionContext);
+};
+
+/**
+ * @class DetectionContextPool
+ * @brief Source of detection contexts for the tasks of a parallel call.
+ *
+ * Tasks may run on any thread of any executor, so rather than owning a
+ * context per worker they take an idle one when they start and hand it back
+ * when they end. Both methods may be called from several threads at once.
+ */
+class DetectionContextPool {
+ public:
+  virtual ~DetectionContextPool() {}
+
+  /** Take a context set up with the current window size and steps */
+  virtual std::unique_ptr<seeta::fd::DetectionContext> AcquireContext() = 0;
+
+  virtual void ReleaseContext(
+    std::unique_ptr<seeta::fd::DetectionContext> ctx) = 0;
+};
+
+}  // namespace fd
+}  // namespace seeta
+
+#endif  // SEETA_FD_DETECTION_CONTEXT_H_
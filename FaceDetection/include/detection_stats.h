@@ -0,0 +1,95 @@
+/*
+ *
+ * This file is part of the open-source SeetaFace engine, which includes three modules:
+ * SeetaFace Detection, SeetaFace Alignment, and SeetaFace Identification.
+ *
+ * This file is part of the SeetaFace Detection module, containing codes implementing the
+ * face detection method described in the following paper:
+ *
+ *
+ *   Funnel-structured cascade for multi-view face detection with alignment awareness,
+ *   Shuzhe Wu, Meina Kan, Zhenliang He, Shiguang Shan, Xilin Chen.
+ *   In Neurocomputing (under review)
+ *
+ *
+ * Copyright (C) 2016, Visual Information Processing and Learning (VIPL) group,
+ * Institute of Computing Technology, Chinese Academy of Sciences, Beijing, China.
+ *
+ * The codes are mainly developed by Shuzhe Wu (a Ph.D supervised by Prof. Shiguang Shan)
+ *
+ * As an open-source face recognition engine: you can redistribute SeetaFace source codes
+ * and/or modify it under the terms of the BSD 2-Clause License.
+ *
+ * You should have received a copy of the BSD 2-Clause License along with the software.
+ * If not, see < https://opensource.org/licenses/BSD-2-Clause>.
+ *
+ * Contact Info: you can send an email to SeetaFace@vipl.ict.ac.cn for any problems.
+ *
+ * Note: the above information must be kept whenever or wherever the codes are used.
+ *
+ */
+
+
+
+#ifndef SEETA_DETECTION_STATS_H_
+#define SEETA_DETECTION_STATS_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace seeta {
+
+/**
+ * @struct DetectionStats
+ * @brief Counters and timings of one `FaceDetection::Detect()` call.
+ *
+ * Times are in microseconds. With several threads the times of a level add
+ * up those of all threads working on it, so they may sum to more than
+ * `total_us`.
+ */
+struct DetectionStats {
+  /** A level of the image pyramid, scanned by the first hierarchy */
+  struct Level {
+    float scale;
+    int32_t width;
+    int32_t height;
+    int64_t resize_us;    /**< building the image of the level */
+    int64_t feat_map_us;  /**< computing its LAB feature maps */
+    int64_t scan_us;      /**< running the LAB classifiers on its windows */
+    int64_t num_wnd;      /**< windows scanned */
+    int64_t num_probe;    /**< windows probed by the coarse-to-fine search */
+    /** Windows passed by each LAB classifier of the first hierarchy */
+    std::vector<int64_t> num_pass;
+
+    Level()
+        : scale(0.0f), width(0), height(0), resize_us(0), feat_map_us(0),
+          scan_us(0), num_wnd(0), num_probe(0) {}
+  };
+
+  /**
+   * A hierarchy of the cascade. For the first one, `num_in` counts the
+   * windows scanned, `num_out` the proposals left after merging them by
+   * non-maximum suppression, and `stage_us` the time of each LAB classifier
+   * over all levels.
+   */
+  struct Hierarchy {
+    int64_t num_in;   /**< proposals entering the hierarchy */
+    int64_t num_out;  /**< proposals passing it */
+    std::vector<int64_t> stage_us;  /**< time of each stage, in model order */
+    int64_t nms_us;   /**< time of non-maximum suppression */
+
+    Hierarchy() : num_in(0), num_out(0), nms_us(0) {}
+  };
+
+  std::vector<Level> levels;
+  std::vector<Hierarchy> hierarchies;
+  int64_t total_us;
+  int32_t num_faces;
+  bool is_partial;  /**< whether the time budget cut the detection short */
+
+  DetectionStats() : total_us(0), num_faces(0), is_partial(false) {}
+};
+
+}  // namespace seeta
+
+#endif  // SEETA_DETECTION_STATS_H_
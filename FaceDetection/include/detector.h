@@ -33,10 +33,13 @@
 #define SEETA_FD_DETECTOR_H_
 
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "common.h"
+#include "detection_context.h"
+#include "executor.h"
 #include "util/image_pyramid.h"
 
 namespace seeta {
@@ -48,10 +51,58 @@ class Detector {
   virtual ~Detector() {}
 
   virtual bool LoadModel(const std::string & model_path) = 0;
-  virtual std::vector<seeta::FaceInfo> Detect(seeta::fd::ImagePyramid* img_pyramid) = 0;
 
-  virtual void SetWindowSize(int32_t size) {}
-  virtual void SetSlideWindowStep(int32_t step_x, int32_t step_y) {}
+  /**
+   * @brief Create the per-call state needed by `Detect()`.
+   *
+   * Each thread calling `Detect()` concurrently needs its own context.
+   */
+  virtual std::unique_ptr<seeta::fd::DetectionContext> CreateContext() const = 0;
+
+  /**
+   * @brief Detect faces on the image held by the pyramid of `ctx`.
+   *
+   * The detector itself is not modified, so it is safe to call this from
+   * multiple threads at once with distinct contexts.
+   */
+  virtual std::vector<seeta::FaceInfo> Detect(
+    seeta::fd::DetectionContext* ctx) const = 0;
+
+  /**
+   * @brief Detect faces on several images, spreading the work over
+   *        `executor`.
+   *
+   * The pyramid levels of all images are scanned in parallel, large levels
+   * being further split into bands of rows, so a batch of a single image
+   * benefits as well. Each task takes its scratch from `ctx_pool`. Results
+   * are returned in the order of `img_pyramids`.
+   */
+  virtual std::vector<std::vector<seeta::FaceInfo> > Detect(
+    const std::vector<seeta::fd::ImagePyramid*> & img_pyramids,
+    seeta::fd::DetectionContextPool* ctx_pool,
+    seeta::Executor* executor) const = 0;
+
+  /**
+   * @brief Switch the boosted classifiers to int16 fixed-point weights.
+   *
+   * Must not be called while detecting.
+   */
+  virtual void SetUseInt16Weights(bool use) = 0;
+
+  /**
+   * @brief Switch the batched MLP classifiers to int8 weights.
+   *
+   * Must not be called while detecting.
+   */
+  virtual void SetUseInt8Weights(bool use) = 0;
+
+  /**
+   * @brief Compute SURF features on the pyramid levels instead of on
+   * resized window crops.
+   *
+   * Must not be called while detecting.
+   */
+  virtual void SetUsePyramidSURFFeatures(bool use) = 0;
 
   DISABLE_COPY_AND_ASSIGN(Detector);
 };
@@ -0,0 +1,94 @@
+/*
+ *
+ * This file is part of the open-source SeetaFace engine, which includes three modules:
+ * SeetaFace Detection, SeetaFace Alignment, and SeetaFace Identification.
+ *
+ * This file is part of the SeetaFace Detection module, containing codes implementing the
+ * face detection method described in the following paper:
+ *
+ *
+ *   Funnel-structured cascade for multi-view face detection with alignment awareness,
+ *   Shuzhe Wu, Meina Kan, Zhenliang He, Shiguang Shan, Xilin Chen.
+ *   In Neurocomputing (under review)
+ *
+ *
+ * Copyright (C) 2016, Visual Information Processing and Learning (VIPL) group,
+ * Institute of Computing Technology, Chinese Academy of Sciences, Beijing, China.
+ *
+ * The codes are mainly developed by Shuzhe Wu (a Ph.D supervised by Prof. Shiguang Shan)
+ *
+ * As an open-source face recognition engine: you can redistribute SeetaFace source codes
+ * and/or modify it under the terms of the BSD 2-Clause License.
+ *
+ * You should have received a copy of the BSD 2-Clause License along with the software.
+ * If not, see < https://opensource.org/licenses/BSD-2-Clause>.
+ *
+ * Contact Info: you can send an email to SeetaFace@vipl.ict.ac.cn for any problems.
+ *
+ * Note: the above information must be kept whenever or wherever the codes are used.
+ *
+ */
+
+
+
+#ifndef SEETA_EXECUTOR_H_
+#define SEETA_EXECUTOR_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include "common.h"
+
+namespace seeta {
+
+/**
+ * @class Executor
+ * @brief Runs the parallel loops of `FaceDetection`.
+ *
+ * The detector splits each call into independent tasks (pyramid levels, bands
+ * of window rows, images of a batch) and hands them to an executor. Loops run
+ * from inside a task are done inline on the thread running the task, so the
+ * detector never nests `ParallelFor()` calls and never uses more threads than
+ * the executor has.
+ *
+ * Besides the executors created below, callers may pass their own, e.g. one
+ * forwarding the tasks to the thread pool of the application.
+ */
+class Executor {
+ public:
+  virtual ~Executor() {}
+
+  /** Number of tasks run at the same time, used to size the work split */
+  virtual int32_t num_threads() const = 0;
+
+  /**
+   * @brief Run `task(0)`, ..., `task(num_tasks - 1)` and wait until all of
+   *        them have finished.
+   *
+   * Tasks are given in the order they should preferably start in. Several
+   * threads may call this at the same time, when `FaceDetection::Detect()`
+   * is called from several threads, including the executor's own tasks when
+   * they call `Detect()` on a detector given the same executor. Executors
+   * must then not wait for the nested calls with all their threads blocked.
+   */
+  virtual void ParallelFor(int32_t num_tasks,
+    const std::function<void(int32_t)> & task) = 0;
+};
+
+/** Executor running every task on the calling thread */
+SEETA_API std::shared_ptr<seeta::Executor> CreateInlineExecutor();
+
+/**
+ * @brief Executor owning a pool of `num_threads` worker threads.
+ *
+ * Non-positive values mean the number of hardware threads. The workers steal
+ * tasks from one another to balance uneven tasks. A task calling
+ * `ParallelFor()` on the same executor runs queued tasks while it waits.
+ */
+SEETA_API std::shared_ptr<seeta::Executor> CreateThreadPoolExecutor(
+    int32_t num_threads);
+
+}  // namespace seeta
+
+#endif  // SEETA_EXECUTOR_H_
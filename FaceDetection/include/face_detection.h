@@ -33,12 +33,27 @@
 #define SEETA_FACE_DETECTION_H_
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 #include "common.h"
+#include "detection_stats.h"
+#include "executor.h"
 
 namespace seeta {
 
+/** Pixel formats of the images given to `FaceDetection` */
+enum ImageFormat {
+  kImageGray,  /**< 8-bit gray, `num_channels` set to 1 */
+  kImageBGR,   /**< interleaved 8-bit B, G, R, `num_channels` set to 3 */
+  kImageRGB,   /**< interleaved 8-bit R, G, B, `num_channels` set to 3 */
+  /**
+   * NV12 or NV21 from video decoders, `num_channels` set to 1: `data` points
+   * to the Y plane of `height` rows, which is all the detector reads.
+   */
+  kImageNV12
+};
+
 class FaceDetection {
  public:
   SEETA_API explicit FaceDetection(const char* model_path);
@@ -47,12 +62,95 @@ class FaceDetection {
   /**
    * @brief Detect faces on input image.
    *
-   * (1) The input image should be gray-scale, i.e. `num_channels` set to 1.
+   * (1) The input image should be of the format set by `SetImageFormat()`,
+   *     which is gray-scale by default, i.e. `num_channels` set to 1.
    * (2) Currently this function does not give the Euler angles, which are
    *     left with invalid values.
+   * (3) The function can be called from multiple threads at the same time.
+   *     The loaded model is shared and each call gets its own scratch
+   *     buffers. The `Set*()` methods must not race with `Detect()`.
+   * (4) With more than one thread (see `SetNumThreads()` and
+   *     `SetExecutor()`), the levels of the image pyramid are scanned in
+   *     parallel on the executor.
    */
   SEETA_API std::vector<seeta::FaceInfo> Detect(const seeta::ImageData & img);
 
+  /**
+   * @brief Same as above, telling whether the result is partial.
+   *
+   * `*is_partial` is set to true when the time budget (see `SetTimeBudget()`)
+   * made the detector skip part of the search.
+   */
+  SEETA_API std::vector<seeta::FaceInfo> Detect(const seeta::ImageData & img,
+      bool* is_partial);
+
+  /**
+   * @brief Same as above, filling `*stats` with the window counts and timings
+   * of each pyramid level and cascade hierarchy.
+   *
+   * Recording is done only for the calls given stats, so that other calls
+   * cost the same as without it.
+   */
+  SEETA_API std::vector<seeta::FaceInfo> Detect(const seeta::ImageData & img,
+      seeta::DetectionStats* stats);
+
+  /**
+   * @brief Detect faces within regions of interest of the input image.
+   *
+   * Only windows centered inside the union of `rois` are scanned, and feature
+   * maps are computed over the bounding box of the regions only. Faces found
+   * are the same as those of `Detect()` centered in the regions, up to the
+   * non-maximum suppression against faces outside of them.
+   */
+  SEETA_API std::vector<seeta::FaceInfo> Detect(const seeta::ImageData & img,
+      const std::vector<seeta::Rect> & rois);
+
+  /**
+   * @brief Detect faces where a binary mask of the input image is nonzero.
+   *
+   * `mask` is a single-channel image whose pixels each cover a cell of
+   * `cell_size` x `cell_size` pixels of `img`, i.e. of size
+   * ceil(width / cell_size) x ceil(height / cell_size), which is the size of
+   * `img` by default. Otherwise the same as the above. An illegal mask gets
+   * an empty result.
+   */
+  SEETA_API std::vector<seeta::FaceInfo> Detect(const seeta::ImageData & img,
+      const seeta::ImageData & mask, int32_t cell_size = 1);
+
+  /**
+   * @brief Detect faces of sizes in [`min_size`, `max_size`] centered in `roi`.
+   *
+   * Only the part of the image around `roi` that such faces may cover is
+   * scanned, over the pyramid levels of the size range, which makes the call
+   * far cheaper than `Detect()` for small regions. The size range is further
+   * limited by `SetMinFaceSize()` and `SetMaxFaceSize()`.
+   */
+  SEETA_API std::vector<seeta::FaceInfo> DetectLocal(
+      const seeta::ImageData & img, const seeta::Rect & roi,
+      int32_t min_size, int32_t max_size);
+
+  /**
+   * @brief Detect faces on a batch of input images.
+   *
+   * Each (image, pyramid level) pair is scheduled as a task on the executor,
+   * so that workers stay busy even when images differ in size.
+   * The i-th result holds the faces of the i-th image, which are the same as
+   * those given by `Detect()` without a time budget: the budget set by
+   * `SetTimeBudget()` is ignored, whatever the number of threads. Illegal
+   * images get an empty result.
+   */
+  SEETA_API std::vector<std::vector<seeta::FaceInfo> > DetectBatch(
+      const std::vector<seeta::ImageData> & imgs);
+
+  /**
+   * @brief Set the pixel format of input images.
+   *
+   * Color images are converted to gray on the fly while building the first
+   * level of the image pyramid, and while cropping the windows of the later
+   * stages, with no full-size gray copy of the image. Gray-scale by default.
+   */
+  SEETA_API void SetImageFormat(seeta::ImageFormat format);
+
   /**
    * @brief Set the minimum size of faces to detect.
    *
@@ -86,6 +184,21 @@ class FaceDetection {
    */
   SEETA_API void SetWindowStep(int32_t step_x, int32_t step_y);
 
+  /**
+   * @brief Search coarse-to-fine, probing windows on a grid of step `step`
+   *        before scanning at the window step.
+   *
+   * Windows `step` pixels apart on each pyramid level first go through the
+   * first few LAB base classifiers with loosened thresholds, and only the
+   * windows less than `step` away from one passing are scanned at the steps
+   * set by `SetWindowStep()`. This saves most of the first stage on images
+   * with few faces, at the cost of missing faces none of whose coarse
+   * neighbors look like one. `step` is rounded down to a multiple of the
+   * window step; values no larger than it, such as the default 0, turn the
+   * coarse-to-fine search off.
+   */
+  SEETA_API void SetCoarseWindowStep(int32_t step);
+
   /**
    * @brief Set the score thresh of detected faces.
    *
@@ -95,6 +208,86 @@ class FaceDetection {
    */
   SEETA_API void SetScoreThresh(float thresh);
 
+  /**
+   * @brief Set the number of threads used by `Detect()` and `DetectBatch()`.
+   *
+   * Non-positive values mean the number of hardware threads, which is also
+   * the default. With a single thread everything runs on the calling thread.
+   * This replaces the executor set by `SetExecutor()` with a thread pool
+   * owned by the detector.
+   */
+  SEETA_API void SetNumThreads(int32_t num);
+
+  /**
+   * @brief Set the executor running the parallel loops of `Detect()` and
+   *        `DetectBatch()`.
+   *
+   * Useful to share the threads of the application instead of having a pool
+   * per detector, see `seeta::Executor`. An executor with a single thread runs
+   * everything on the calling thread. nullptr restores the default, a pool of
+   * the number of threads set by `SetNumThreads()`. The executor is kept
+   * alive as long as the detector uses it.
+   */
+  SEETA_API void SetExecutor(const std::shared_ptr<seeta::Executor> & executor);
+
+  /**
+   * @brief Set the time allowed for each call of `Detect()`, in microseconds.
+   *
+   * When the budget runs short, the pyramid levels of the smallest faces are
+   * skipped first, and only the best scoring candidate windows are passed to
+   * the later stages, so that the call returns about on time with the faces
+   * found so far. The image pyramid is still built in full, which bounds how
+   * small a budget can be met. Non-positive values mean no limit, which is
+   * the default. `DetectBatch()` ignores the budget.
+   */
+  SEETA_API void SetTimeBudget(int64_t microseconds);
+
+  /**
+   * @brief Bound the memory the sliding window uses for each pyramid level,
+   *        in bytes, to detect on very large images.
+   *
+   * The windows of each level are scanned in overlapping tiles whose pixels
+   * and feature maps fit in `bytes`, each window belonging to exactly one
+   * tile, and the pixels of a tile are resized from the input image when
+   * needed instead of building the image pyramid. This keeps the memory of a
+   * call, and the sums in the integral images, independent of the image
+   * size. Scores may change slightly since levels are then all resized from
+   * the input image. The windows grouped by `SetUsePyramidSURFFeatures()`
+   * are bounded by the limit as well. A tile holds at least one window
+   * whatever the limit; about 14 bytes are needed per pixel of a tile.
+   * Non-positive values mean no tiling, which is the default.
+   */
+  SEETA_API void SetTileMemoryLimit(int64_t bytes);
+
+  /**
+   * @brief Use int16 fixed-point weights in the first (LAB) stage.
+   *
+   * This halves the memory footprint of the stage's weight tables. Scores
+   * may change slightly due to the rounding of the weights. Disabled by
+   * default.
+   */
+  SEETA_API void SetUseInt16Weights(bool use);
+
+  /**
+   * @brief Use int8 weights in the later (SURF-MLP) stages.
+   *
+   * Inputs of each layer are quantized to int16 and products accumulated in
+   * int32, which is several times cheaper than the float path. Scores may
+   * change slightly. Disabled by default.
+   */
+  SEETA_API void SetUseInt8Weights(bool use);
+
+  /**
+   * @brief Compute the SURF features of the later stages on pyramid levels.
+   *
+   * Instead of cropping and resizing every candidate window, each window is
+   * mapped to the pyramid level closest to its scale and its features are
+   * taken from gradient integral images computed once for the windows of that
+   * level. Scores change slightly since the window size on the level is only
+   * approximately that of the model. Disabled by default.
+   */
+  SEETA_API void SetUsePyramidSURFFeatures(bool use);
+
   DISABLE_COPY_AND_ASSIGN(FaceDetection);
 
  private:
@@ -0,0 +1,122 @@
+/*
+ *
+ * This file is part of the open-source SeetaFace engine, which includes three modules:
+ * SeetaFace Detection, SeetaFace Alignment, and SeetaFace Identification.
+ *
+ * This file is part of the SeetaFace Detection module, containing codes implementing the
+ * face detection method described in the following paper:
+ *
+ *
+ *   Funnel-structured cascade for multi-view face detection with alignment awareness,
+ *   Shuzhe Wu, Meina Kan, Zhenliang He, Shiguang Shan, Xilin Chen.
+ *   In Neurocomputing (under review)
+ *
+ *
+ * Copyright (C) 2016, Visual Information Processing and Learning (VIPL) group,
+ * Institute of Computing Technology, Chinese Academy of Sciences, Beijing, China.
+ *
+ * The codes are mainly developed by Shuzhe Wu (a Ph.D supervised by Prof. Shiguang Shan)
+ *
+ * As an open-source face recognition engine: you can redistribute SeetaFace source codes
+ * and/or modify it under the terms of the BSD 2-Clause License.
+ *
+ * You should have received a copy of the BSD 2-Clause License along with the software.
+ * If not, see < https://opensource.org/licenses/BSD-2-Clause>.
+ *
+ * Contact Info: you can send an email to SeetaFace@vipl.ict.ac.cn for any problems.
+ *
+ * Note: the above information must be kept whenever or wherever the codes are used.
+ *
+ */
+
+
+#ifndef SEETA_FACE_TRACKER_H_
+#define SEETA_FACE_TRACKER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "common.h"
+#include "face_detection.h"
+
+namespace seeta {
+
+namespace fd {
+class MotionDetector;
+}
+
+/**
+ * @class FaceTracker
+ * @brief Face detection on the frames of a video stream.
+ *
+ * Every few frames the whole frame is scanned with `FaceDetection::Detect()`.
+ * In between, each face of the previous frame is looked for only around its
+ * last position and within a band of sizes around its last size, by
+ * `FaceDetection::DetectLocal()`. The later stages of the cascade regress the
+ * boxes found there, so that faces follow the moving ones. New faces are
+ * picked up at the next full scan.
+ *
+ * With the motion gate on, blocks of each frame that changed from a background
+ * model of the stream are found first. Faces whose surroundings did not
+ * change are kept as they are, and full scans after the first one search only
+ * the changed blocks.
+ *
+ * A tracker holds the state of one stream. Trackers of different streams may
+ * share a detector and run on different threads.
+ */
+class FaceTracker {
+ public:
+  SEETA_API explicit FaceTracker(seeta::FaceDetection* detector);
+  SEETA_API ~FaceTracker();
+
+  /** @brief Detect faces on the next frame of the stream. */
+  SEETA_API std::vector<seeta::FaceInfo> Track(const seeta::ImageData & img);
+
+  /**
+   * @brief Set the number of frames between full scans (Default: 10).
+   *
+   * A value of 1 scans every frame in full. Invalid values will be ignored.
+   */
+  SEETA_API void SetFullScanInterval(int32_t interval);
+
+  /**
+   * @brief Set the area searched around each face between full scans.
+   *
+   * Faces are searched with centers within `shift_ratio` times the last face
+   * size of the last center, and sizes within a factor of `scale_ratio` of
+   * the last size (Default: 0.5, 1.5). Invalid values will be ignored.
+   */
+  SEETA_API void SetSearchRange(float shift_ratio, float scale_ratio);
+
+  /**
+   * @brief Skip the areas that did not change since the previous frames.
+   *
+   * Blocks of 32 x 32 pixels change when the mean absolute difference of
+   * their pixels from the background exceeds `thresh` (Default: off, 4).
+   */
+  SEETA_API void SetUseMotionGate(bool use, int32_t thresh = 4);
+
+  /**
+   * @brief Scan the next frame in full, e.g. on a scene cut.
+   */
+  SEETA_API void RequestFullScan() { full_scan_requested_ = true; }
+
+  /** @brief Forget the faces of the previous frames. */
+  SEETA_API void Reset();
+
+  DISABLE_COPY_AND_ASSIGN(FaceTracker);
+
+ private:
+  seeta::FaceDetection* detector_;
+  seeta::fd::MotionDetector* motion_detector_;
+  std::vector<seeta::FaceInfo> faces_;
+  int32_t full_scan_interval_;
+  int32_t num_frame_since_scan_;
+  bool full_scan_requested_;
+  float shift_ratio_;
+  float scale_ratio_;
+};
+
+}  // namespace seeta
+
+#endif  // SEETA_FACE_TRACKER_H_
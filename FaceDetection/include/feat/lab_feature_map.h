@@ -49,7 +49,7 @@ typedef struct LABFeature {
   int32_t y;
 } LABFeature;
 
-class LABFeatureMap : public seeta::fd::FeatureMap {
+class LABFeatureMap final : public seeta::fd::FeatureMap {
  public:
   LABFeatureMap() : rect_width_(3), rect_height_(3), num_rect_(3) {}
   virtual ~LABFeatureMap() {}
@@ -60,7 +60,15 @@ class LABFeatureMap : public seeta::fd::FeatureMap {
     return feat_map_[(roi_.y + offset_y) * width_ + roi_.x + offset_x];
   }
 
-  float GetStdDev() const;
+  inline float GetStdDev() const {
+    return GetStdDev(roi_);
+  }
+
+  /** Standard deviation of the pixels in `roi`, ignoring the current ROI */
+  float GetStdDev(const seeta::Rect & roi) const;
+
+  inline const uint8_t* feat_map() const { return feat_map_.data(); }
+  inline int32_t width() const { return width_; }
 
  private:
   void Reshape(int32_t width, int32_t height);
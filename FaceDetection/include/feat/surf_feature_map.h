@@ -104,19 +104,16 @@ class SURFFeaturePool {
   std::vector<SURFPatchFormat> format_;
 };
 
-class SURFFeatureMap : public FeatureMap {
+class SURFFeatureMap final : public FeatureMap {
  public:
-  SURFFeatureMap() : buf_valid_reset_(false) { InitFeaturePool(); }
+  SURFFeatureMap() : epoch_(1) { InitFeaturePool(); }
   virtual ~SURFFeatureMap() {}
 
   virtual void Compute(const uint8_t* input, int32_t width, int32_t height);
 
   inline virtual void SetROI(const seeta::Rect & roi) {
     roi_ = roi;
-    if (buf_valid_reset_) {
-      std::memset(buf_valid_.data(), 0, buf_valid_.size() * sizeof(int32_t));
-      buf_valid_reset_ = false;
-    }
+    NextEpoch();
   }
 
   inline int32_t GetFeatureVectorDim(int32_t feat_id) const {
@@ -124,7 +121,13 @@ class SURFFeatureMap : public FeatureMap {
       feat_pool_[feat_id].num_cell_per_row * kNumIntChannel);
   }
 
-  void GetFeatureVector(int32_t featID, float* featVec);
+  /**
+   * @brief Normalized feature vector `feat_id` of the current ROI.
+   *
+   * The vector is computed on first use and cached in place. The returned
+   * pointer stays valid until the next call to `Compute()` or `SetROI()`.
+   */
+  const float* GetFeatureVector(int32_t feat_id);
 
  private:
   void InitFeaturePool();
@@ -157,17 +160,30 @@ class SURFFeatureMap : public FeatureMap {
    */
   void VectorCumAdd(int32_t* x, int32_t len, int32_t num_channel);
 
+  /**
+   * Invalidate all cached feature vectors. A vector is valid only if it was
+   * computed in the current epoch, so no per-vector state is cleared.
+   */
+  inline void NextEpoch() {
+    if (++epoch_ == 0) {
+      std::memset(feat_vec_epoch_.data(), 0,
+        feat_vec_epoch_.size() * sizeof(uint32_t));
+      epoch_ = 1;
+    }
+  }
+
   static const int32_t kNumIntChannel = 8;
 
-  bool buf_valid_reset_;
+  uint32_t epoch_;
 
   std::vector<int32_t> grad_x_;
   std::vector<int32_t> grad_y_;
   std::vector<int32_t> int_img_;
   std::vector<int32_t> img_buf_;
-  std::vector<std::vector<int32_t> > feat_vec_buf_;
-  std::vector<std::vector<float> > feat_vec_normed_buf_;
-  std::vector<int32_t> buf_valid_;
+  std::vector<int32_t> feat_vec_buf_;
+  std::vector<float> feat_vec_normed_;     /**< all vectors, back to back */
+  std::vector<int32_t> feat_vec_offset_;   /**< offset of each vector */
+  std::vector<uint32_t> feat_vec_epoch_;   /**< epoch each was computed in */
 
   seeta::fd::SURFFeaturePool feat_pool_;
 };
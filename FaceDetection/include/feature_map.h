@@ -32,7 +32,11 @@
 #ifndef SEETA_FD_FEATURE_MAP_H_
 #define SEETA_FD_FEATURE_MAP_H_
 
+#include <cstdint>
+#include <vector>
+
 #include "common.h"
+#include "executor.h"
 
 namespace seeta {
 namespace fd {
@@ -40,7 +44,7 @@ namespace fd {
 class FeatureMap {
  public:
   FeatureMap()
-      : width_(0), height_(0) {
+      : width_(0), height_(0), executor_(nullptr) {
     roi_.x = 0;
     roi_.y = 0;
     roi_.width = 0;
@@ -55,11 +59,38 @@ class FeatureMap {
     roi_ = roi;
   }
 
+  /**
+   * @brief Scratch memory of at least `len` floats for the classifiers
+   *        evaluated on this map.
+   *
+   * Feature maps belong to a detection context while classifiers are shared,
+   * so classifier temporaries are kept here rather than in the classifier.
+   */
+  inline float* GetBuffer(int32_t len) {
+    if (static_cast<int32_t>(buf_.size()) < len)
+      buf_.resize(len);
+    return buf_.data();
+  }
+
+  /**
+   * @brief Set the executor running the row loops of `Compute()`, nullptr
+   *        (the default) to run them on the calling thread.
+   */
+  inline void SetExecutor(seeta::Executor* executor) {
+    executor_ = executor;
+  }
+
+  inline seeta::Executor* executor() const { return executor_; }
+
  protected:
   int32_t width_;
   int32_t height_;
 
   seeta::Rect roi_;
+  seeta::Executor* executor_;
+
+ private:
+  std::vector<float> buf_;
 };
 
 }  // namespace fd
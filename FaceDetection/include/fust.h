@@ -34,7 +34,6 @@
 
 #include <algorithm>
 #include <fstream>
-#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -47,54 +46,143 @@
 namespace seeta {
 namespace fd {
 
+class LABBoostedClassifier;
+class LABFeatureMap;
+class SURFMLP;
+
 class FuStDetector : public Detector {
  public:
-  FuStDetector()
-      : wnd_size_(40), slide_wnd_step_x_(4), slide_wnd_step_y_(4),
-        num_hierarchy_(0) {
-    wnd_data_buf_.resize(wnd_size_ * wnd_size_);
-    wnd_data_.resize(wnd_size_ * wnd_size_);
-  }
-
+  FuStDetector() : num_hierarchy_(0), use_pyramid_surf_(false) {}
   ~FuStDetector() {}
 
   virtual bool LoadModel(const std::string & model_path);
-  virtual std::vector<seeta::FaceInfo> Detect(seeta::fd::ImagePyramid* img_pyramid);
-
-  inline virtual void SetWindowSize(int32_t size) {
-    if (size >= 20)
-      wnd_size_ = size;
-  }
-
-  inline virtual void SetSlideWindowStep(int32_t step_x, int32_t step_y) {
-    if (step_x > 0)
-      slide_wnd_step_x_ = step_x;
-    if (step_y > 0)
-      slide_wnd_step_y_ = step_y;
+  virtual std::unique_ptr<seeta::fd::DetectionContext> CreateContext() const;
+  virtual std::vector<seeta::FaceInfo> Detect(
+    seeta::fd::DetectionContext* ctx) const;
+  virtual std::vector<std::vector<seeta::FaceInfo> > Detect(
+    const std::vector<seeta::fd::ImagePyramid*> & img_pyramids,
+    seeta::fd::DetectionContextPool* ctx_pool,
+    seeta::Executor* executor) const;
+  virtual void SetUseInt16Weights(bool use);
+  virtual void SetUseInt8Weights(bool use);
+  inline virtual void SetUsePyramidSURFFeatures(bool use) {
+    use_pyramid_surf_ = use;
   }
 
  private:
-  std::shared_ptr<seeta::fd::ModelReader> CreateModelReader(seeta::fd::ClassifierType type);
-  std::shared_ptr<seeta::fd::Classifier> CreateClassifier(seeta::fd::ClassifierType type);
-  std::shared_ptr<seeta::fd::FeatureMap> CreateFeatureMap(seeta::fd::ClassifierType type);
-
-  void GetWindowData(const seeta::ImageData & img, const seeta::Rect & wnd);
-
-  int32_t wnd_size_;
-  int32_t slide_wnd_step_x_;
-  int32_t slide_wnd_step_y_;
+  /**
+   * A classifier of the cascade resolved to its concrete type at load time,
+   * so that the window loops call it directly rather than through the
+   * `Classifier` interface. Exactly one of `lab` and `surf_mlp` is set.
+   */
+  typedef struct CascadeStage {
+    const seeta::fd::LABBoostedClassifier* lab;
+    const seeta::fd::SURFMLP* surf_mlp;
+    int32_t feat_map_idx;  /**< feature map index in detection contexts */
+    int32_t branch_end;  /**< index past the last model of its classifier */
+    int32_t hierarchy_end;  /**< index past the last model of its hierarchy */
+  } CascadeStage;
+
+  std::shared_ptr<seeta::fd::ModelReader> CreateModelReader(seeta::fd::ClassifierType type) const;
+  std::shared_ptr<seeta::fd::Classifier> CreateClassifier(seeta::fd::ClassifierType type) const;
+  std::shared_ptr<seeta::fd::FeatureMap> CreateFeatureMap(seeta::fd::ClassifierType type) const;
+
+  /**
+   * Windows of a pyramid level to scan, as ranges of window columns and rows.
+   * Windows whose centers fall outside the bounding box of the mask of the
+   * pyramid are left out.
+   */
+  seeta::Rect GetWindowRange(const seeta::fd::ImagePyramid* img_pyramid,
+    int32_t level, const seeta::fd::DetectionContext* ctx) const;
+
+  /**
+   * Run the first hierarchy on the windows of a pyramid level within
+   * `wnd_range`. With a tile memory limit set in `ctx`, the range is split
+   * into tiles scanned one after another, each window belonging to exactly
+   * one tile.
+   */
+  void SlideWindow(const seeta::fd::ImagePyramid* img_pyramid, int32_t level,
+    const seeta::Rect & wnd_range, seeta::fd::DetectionContext* ctx,
+    std::vector<std::vector<seeta::FaceInfo> >* proposals) const;
+
+  /**
+   * Scan the windows of `wnd_range` as one tile for `SlideWindow()`,
+   * skipping those centered outside the mask of the pyramid. The feature
+   * maps cover the pixels under the windows of the range only. In
+   * coarse-to-fine mode, only windows near a coarse window passing
+   * `ProbeWindows()` are run.
+   */
+  void ScanWindows(const seeta::fd::ImagePyramid* img_pyramid, int32_t level,
+    const seeta::Rect & wnd_range, seeta::fd::DetectionContext* ctx,
+    std::vector<std::vector<seeta::FaceInfo> >* proposals) const;
+
+  /**
+   * Coarse windows to probe for `wnd_range` on a level of the given size:
+   * every `*ratio_x`-th and `*ratio_y`-th window, counted from the first of
+   * the level so that any range probes the same windows, and less than a
+   * coarse step away from the range. Returns false when the coarse-to-fine
+   * mode is off.
+   */
+  bool GetProbeRange(int32_t width, int32_t height,
+    const seeta::Rect & wnd_range, const seeta::fd::DetectionContext* ctx,
+    int32_t* ratio_x, int32_t* ratio_y, seeta::Rect* probe_range) const;
+
+  /**
+   * Probe the coarse windows of `probe_range` with the first base classifiers
+   * of the first hierarchy, and flag the windows of `wnd_range` less than a
+   * coarse step away from one passing any of them. `feat_map` covers the
+   * windows of `map_range`. Returns the number of windows probed.
+   */
+  int32_t ProbeWindows(const seeta::fd::LABFeatureMap* feat_map,
+    const seeta::Rect & map_range, const seeta::Rect & probe_range,
+    int32_t ratio_x, int32_t ratio_y, const seeta::Rect & wnd_range,
+    const seeta::fd::DetectionContext* ctx, uint8_t* wnd_flag) const;
+
+  /** Merge the first hierarchy proposals and pass them through the rest. */
+  std::vector<seeta::FaceInfo> RunFollowingClassifiers(
+    std::vector<std::vector<seeta::FaceInfo> >* proposals,
+    const seeta::fd::ImagePyramid* img_pyramid,
+    seeta::fd::DetectionContext* ctx) const;
+
+  /**
+   * Classify the windows in `bboxes` with the `model_idx`-th classifier.
+   * Windows passing it are replaced by their regressed boxes and moved to
+   * the front, and their number is returned. SURF-MLP classifiers run on
+   * all windows as one batch.
+   */
+  int32_t ClassifyWindows(const seeta::fd::ImagePyramid* img_pyramid,
+    int32_t model_idx, seeta::fd::FeatureMap* feat_map,
+    seeta::fd::DetectionContext* ctx,
+    std::vector<seeta::FaceInfo>* bboxes) const;
+
+  /**
+   * Same as `ClassifyWindows()` under the time budget of the pyramid. Only
+   * the best scoring windows that this and the following models are expected
+   * to take in the remaining time are classified, and the measured cost per
+   * window and number of windows are recorded in `ctx`.
+   */
+  int32_t ClassifyWindowsInBudget(const seeta::fd::ImagePyramid* img_pyramid,
+    int32_t model_idx, seeta::fd::FeatureMap* feat_map,
+    seeta::fd::DetectionContext* ctx,
+    std::vector<seeta::FaceInfo>* bboxes) const;
+
+  static void RegressBBox(const seeta::FaceInfo & wnd,
+    const float* mlp_predicts, float score, seeta::FaceInfo* face);
+
+  /** Crop `wnd` from the 1x image in gray, resized to the window size */
+  void GetWindowData(const seeta::fd::ImagePyramid* img_pyramid,
+    const seeta::Rect & wnd, seeta::fd::DetectionContext* ctx) const;
 
   int32_t num_hierarchy_;
   std::vector<int32_t> hierarchy_size_;
   std::vector<int32_t> num_stage_;
   std::vector<std::vector<int32_t> > wnd_src_id_;
 
-  std::vector<uint8_t> wnd_data_buf_;
-  std::vector<uint8_t> wnd_data_;
-
   std::vector<std::shared_ptr<seeta::fd::Classifier> > model_;
-  std::vector<std::shared_ptr<seeta::fd::FeatureMap> > feat_map_;
-  std::map<seeta::fd::ClassifierType, int32_t> cls2feat_idx_;
+  std::vector<CascadeStage> stages_;  /**< one for each of `model_` */
+  std::vector<seeta::fd::ClassifierType> feat_map_type_;
+
+  bool use_pyramid_surf_;
 
   DISABLE_COPY_AND_ASSIGN(FuStDetector);
 };
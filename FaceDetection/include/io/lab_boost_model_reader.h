@@ -50,9 +50,9 @@ class LABBoostModelReader : public ModelReader {
 
  private:
   bool ReadFeatureParam(std::istream* input,
-    seeta::fd::LABBoostedClassifier* model);
+    seeta::fd::LABModelTable* table);
   bool ReadBaseClassifierParam(std::istream* input,
-    seeta::fd::LABBoostedClassifier* model);
+    seeta::fd::LABModelTable* table);
 
   int32_t num_bin_;
   int32_t num_base_classifer_;
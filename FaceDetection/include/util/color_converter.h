@@ -0,0 +1,63 @@
+/*
+ *
+ * This file is part of the open-source SeetaFace engine, which includes three modules:
+ * SeetaFace Detection, SeetaFace Alignment, and SeetaFace Identification.
+ *
+ * This file is part of the SeetaFace Detection module, containing codes implementing the
+ * face detection method described in the following paper:
+ *
+ *
+ *   Funnel-structured cascade for multi-view face detection with alignment awareness,
+ *   Shuzhe Wu, Meina Kan, Zhenliang He, Shiguang Shan, Xilin Chen.
+ *   In Neurocomputing (under review)
+ *
+ *
+ * Copyright (C) 2016, Visual Information Processing and Learning (VIPL) group,
+ * Institute of Computing Technology, Chinese Academy of Sciences, Beijing, China.
+ *
+ * The codes are mainly developed by Shuzhe Wu (a Ph.D supervised by Prof. Shiguang Shan)
+ *
+ * As an open-source face recognition engine: you can redistribute SeetaFace source codes
+ * and/or modify it under the terms of the BSD 2-Clause License.
+ *
+ * You should have received a copy of the BSD 2-Clause License along with the software.
+ * If not, see < https://opensource.org/licenses/BSD-2-Clause>.
+ *
+ * Contact Info: you can send an email to SeetaFace@vipl.ict.ac.cn for any problems.
+ *
+ * Note: the above information must be kept whenever or wherever the codes are used.
+ *
+ */
+
+
+#ifndef SEETA_FD_UTIL_COLOR_CONVERTER_H_
+#define SEETA_FD_UTIL_COLOR_CONVERTER_H_
+
+#include <cstdint>
+
+#include "common.h"
+
+namespace seeta {
+namespace fd {
+
+/** Order of the channels of interleaved 3-channel pixels */
+enum ChannelOrder {
+  kChannelBGR,
+  kChannelRGB
+};
+
+/**
+ * @brief Convert a row of `len` pixels to gray.
+ *
+ * Gray pixels (`num_channels` 1) are copied as they are. 3-channel pixels are
+ * weighted as in BT.601 with 8-bit weights, i.e.
+ * (77 R + 150 G + 29 B + 128) >> 8, 16 pixels at a time with SSE when
+ * enabled. Results may differ from 14-bit conversions by one gray level.
+ */
+void ConvertRowToGray(const uint8_t* src, int32_t len, int32_t num_channels,
+  ChannelOrder order, uint8_t* dest);
+
+}  // namespace fd
+}  // namespace seeta
+
+#endif  // SEETA_FD_UTIL_COLOR_CONVERTER_H_
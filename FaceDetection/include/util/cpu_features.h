@@ -0,0 +1,60 @@
+/*
+ *
+ * This file is part of the open-source SeetaFace engine, which includes three modules:
+ * SeetaFace Detection, SeetaFace Alignment, and SeetaFace Identification.
+ *
+ * This file is part of the SeetaFace Detection module, containing codes implementing the
+ * face detection method described in the following paper:
+ *
+ *
+ *   Funnel-structured cascade for multi-view face detection with alignment awareness,
+ *   Shuzhe Wu, Meina Kan, Zhenliang He, Shiguang Shan, Xilin Chen.
+ *   In Neurocomputing (under review)
+ *
+ *
+ * Copyright (C) 2016, Visual Information Processing and Learning (VIPL) group,
+ * Institute of Computing Technology, Chinese Academy of Sciences, Beijing, China.
+ *
+ * The codes are mainly developed by Shuzhe Wu (a Ph.D supervised by Prof. Shiguang Shan)
+ *
+ * As an open-source face recognition engine: you can redistribute SeetaFace source codes
+ * and/or modify it under the terms of the BSD 2-Clause License.
+ *
+ * You should have received a copy of the BSD 2-Clause License along with the software.
+ * If not, see < https://opensource.org/licenses/BSD-2-Clause>.
+ *
+ * Contact Info: you can send an email to SeetaFace@vipl.ict.ac.cn for any problems.
+ *
+ * Note: the above information must be kept whenever or wherever the codes are used.
+ *
+ */
+
+
+
+#ifndef SEETA_FD_UTIL_CPU_FEATURES_H_
+#define SEETA_FD_UTIL_CPU_FEATURES_H_
+
+namespace seeta {
+namespace fd {
+
+/** Instruction set extensions usable on the running CPU and OS */
+typedef struct CPUFeatures {
+  bool avx2;
+  bool avx512f;
+} CPUFeatures;
+
+/**
+ * @brief Features of the running CPU, detected on first use.
+ *
+ * AVX and AVX-512 features are reported only when the OS saves their
+ * registers. The environment variable `SEETA_CPU_MAX_ISA`, one of "sse4.1",
+ * "avx2" and "avx512", caps the features reported, e.g. to compare kernels
+ * on a single machine. The baseline kernels, SSE4.1 or plain C, are chosen
+ * at build time.
+ */
+const CPUFeatures & GetCPUFeatures();
+
+}  // namespace fd
+}  // namespace seeta
+
+#endif  // SEETA_FD_UTIL_CPU_FEATURES_H_
@@ -0,0 +1,98 @@
+/*
+ *
+ * This file is part of the open-source SeetaFace engine, which includes three modules:
+ * SeetaFace Detection, SeetaFace Alignment, and SeetaFace Identification.
+ *
+ * This file is part of the SeetaFace Detection module, containing codes implementing the
+ * face detection method described in the following paper:
+ *
+ *
+ *   Funnel-structured cascade for multi-view face detection with alignment awareness,
+ *   Shuzhe Wu, Meina Kan, Zhenliang He, Shiguang Shan, Xilin Chen.
+ *   In Neurocomputing (under review)
+ *
+ *
+ * Copyright (C) 2016, Visual Information Processing and Learning (VIPL) group,
+ * Institute of Computing Technology, Chinese Academy of Sciences, Beijing, China.
+ *
+ * The codes are mainly developed by Shuzhe Wu (a Ph.D supervised by Prof. Shiguang Shan)
+ *
+ * As an open-source face recognition engine: you can redistribute SeetaFace source codes
+ * and/or modify it under the terms of the BSD 2-Clause License.
+ *
+ * You should have received a copy of the BSD 2-Clause License along with the software.
+ * If not, see < https://opensource.org/licenses/BSD-2-Clause>.
+ *
+ * Contact Info: you can send an email to SeetaFace@vipl.ict.ac.cn for any problems.
+ *
+ * Note: the above information must be kept whenever or wherever the codes are used.
+ *
+ */
+
+
+#ifndef SEETA_FD_UTIL_DETECTION_MASK_H_
+#define SEETA_FD_UTIL_DETECTION_MASK_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "common.h"
+
+namespace seeta {
+namespace fd {
+
+/**
+ * @class DetectionMask
+ * @brief Regions of an image where faces are searched for.
+ *
+ * The mask has the size of the input image and a window is scanned only if
+ * its center falls on an allowed pixel. The bounding box of the allowed
+ * pixels bounds the area over which feature maps are computed.
+ */
+class DetectionMask {
+ public:
+  DetectionMask()
+      : width_(0), height_(0), cell_size_(1), mask_width_(0), mask_height_(0) {
+    bbox_.x = bbox_.y = bbox_.width = bbox_.height = 0;
+  }
+  ~DetectionMask() {}
+
+  /** Allow the union of `rois`, clipped to the image. */
+  void SetRects(int32_t width, int32_t height,
+    const std::vector<seeta::Rect> & rois);
+
+  /**
+   * Allow the pixels of a `width` x `height` image where `mask` is nonzero.
+   * Each element of `mask` covers a cell of `cell_size` x `cell_size` pixels,
+   * so that the mask has ceil(width / cell_size) columns and
+   * ceil(height / cell_size) rows.
+   */
+  void SetMask(int32_t width, int32_t height, const uint8_t* mask,
+    int32_t cell_size = 1);
+
+  inline bool Contains(int32_t x, int32_t y) const {
+    return (x >= 0 && x < width_ && y >= 0 && y < height_ &&
+      mask_[(y / cell_size_) * mask_width_ + x / cell_size_] != 0);
+  }
+
+  /** Bounding box of the allowed pixels, empty if none is allowed */
+  inline const seeta::Rect & bbox() const { return bbox_; }
+
+ private:
+  void UpdateBBox();
+
+  int32_t width_;
+  int32_t height_;
+  int32_t cell_size_;
+  int32_t mask_width_;
+  int32_t mask_height_;
+  std::vector<uint8_t> mask_;
+  seeta::Rect bbox_;
+
+  DISABLE_COPY_AND_ASSIGN(DetectionMask);
+};
+
+}  // namespace fd
+}  // namespace seeta
+
+#endif  // SEETA_FD_UTIL_DETECTION_MASK_H_
@@ -35,13 +35,24 @@
 #include <cstdint>
 #include <string>
 #include <cstring>
+#include <vector>
 
 #include "common.h"
+#include "executor.h"
+#include "util/color_converter.h"
+#include "util/detection_mask.h"
+#include "util/parallel_for.h"
+#include "util/stats_recorder.h"
+#include "util/time_budget.h"
+#include "util/image_resizer.h"
 
 namespace seeta {
 	namespace fd {
 
-		static void ResizeImage(const seeta::ImageData & src, seeta::ImageData* dest) {
+		// Bilinear resizing of `src` into `dest`, splitting the rows over
+		// `executor` when not nullptr
+		static void ResizeImage(const seeta::ImageData & src, seeta::ImageData* dest,
+			seeta::Executor* executor = nullptr) {
 			int32_t src_width = src.width;
 			int32_t src_height = src.height;
 			int32_t dest_width = dest->width;
@@ -56,32 +67,28 @@ namespace seeta {
 			const uint8_t* src_data = src.data;
 			uint8_t* dest_data = dest->data;
 
-#pragma omp parallel num_threads(SEETA_NUM_THREADS)
-			{
-#pragma omp for nowait
-				for (int32_t y = 0; y < dest_height; y++) {
-					for (int32_t x = 0; x < dest_width; x++) {
-						double lf_x_s = lf_x_scl * x;
-						double lf_y_s = lf_y_Scl * y;
-
-						int32_t n_x_s = static_cast<int>(lf_x_s);
-						n_x_s = (n_x_s <= (src_width - 2) ? n_x_s : (src_width - 2));
-						int32_t n_y_s = static_cast<int>(lf_y_s);
-						n_y_s = (n_y_s <= (src_height - 2) ? n_y_s : (src_height - 2));
-
-						double lf_weight_x = lf_x_s - n_x_s;
-						double lf_weight_y = lf_y_s - n_y_s;
-
-						double dest_val = (1 - lf_weight_y) * ((1 - lf_weight_x) *
-							src_data[n_y_s * src_width + n_x_s] +
-							lf_weight_x * src_data[n_y_s * src_width + n_x_s + 1]) +
-							lf_weight_y * ((1 - lf_weight_x) * src_data[(n_y_s + 1) * src_width + n_x_s] +
-								lf_weight_x * src_data[(n_y_s + 1) * src_width + n_x_s + 1]);
-
-						dest_data[y * dest_width + x] = static_cast<uint8_t>(dest_val);
-					}
+			seeta::fd::ParallelFor(executor, 0, dest_height, [&](int32_t y) {
+				for (int32_t x = 0; x < dest_width; x++) {
+					double lf_x_s = lf_x_scl * x;
+					double lf_y_s = lf_y_Scl * y;
+
+					int32_t n_x_s = static_cast<int>(lf_x_s);
+					n_x_s = (n_x_s <= (src_width - 2) ? n_x_s : (src_width - 2));
+					int32_t n_y_s = static_cast<int>(lf_y_s);
+					n_y_s = (n_y_s <= (src_height - 2) ? n_y_s : (src_height - 2));
+
+					double lf_weight_x = lf_x_s - n_x_s;
+					double lf_weight_y = lf_y_s - n_y_s;
+
+					double dest_val = (1 - lf_weight_y) * ((1 - lf_weight_x) *
+						src_data[n_y_s * src_width + n_x_s] +
+						lf_weight_x * src_data[n_y_s * src_width + n_x_s + 1]) +
+						lf_weight_y * ((1 - lf_weight_x) * src_data[(n_y_s + 1) * src_width + n_x_s] +
+							lf_weight_x * src_data[(n_y_s + 1) * src_width + n_x_s + 1]);
+
+					dest_data[y * dest_width + x] = static_cast<uint8_t>(dest_val);
 				}
-			}
+			});
 		}
 
 		// ͼ
@@ -89,85 +96,174 @@ namespace seeta {
 		public:
 			ImagePyramid()
 				: max_scale_(1.0f), min_scale_(1.0f),
-				scale_factor_(1.0f), scale_step_(0.8f),
+				scale_step_(0.8f),
 				width1x_(0), height1x_(0),
-				width_scaled_(0), height_scaled_(0),
-				buf_img_width_(2), buf_img_height_(2),
-				buf_scaled_width_(2), buf_scaled_height_(2) {
-				buf_img_ = new uint8_t[buf_img_width_ * buf_img_height_];
-				buf_img_scaled_ = new uint8_t[buf_scaled_width_ * buf_scaled_height_];
-			}
-
-			~ImagePyramid() {
-				delete[] buf_img_;
-				buf_img_ = nullptr;
+				img1x_data_(nullptr), img1x_stride_(0), img1x_channels_(1),
+				channel_order_(kChannelBGR),
+				is_built_(false), mask_(nullptr),
+				time_budget_(nullptr), stats_recorder_(nullptr) {}
 
-				buf_img_width_ = 0;
-				buf_img_height_ = 0;
-
-				delete[] buf_img_scaled_;
-				buf_img_scaled_ = nullptr;
-
-				buf_scaled_width_ = 0;
-				buf_scaled_height_ = 0;
-
-				img_scaled_.data = nullptr;
-				img_scaled_.width = 0;
-				img_scaled_.height = 0;
-			}
+			~ImagePyramid() {}
 
 			inline void SetScaleStep(float step) {
-				if (step > 0.0f && step <= 1.0f)
+				if (step > 0.0f && step <= 1.0f) {
 					scale_step_ = step;
+					is_built_ = false;
+				}
 			}
 
 			inline void SetMinScale(float min_scale) {
 				min_scale_ = min_scale;
+				is_built_ = false;
 			}
 
 			inline void SetMaxScale(float max_scale) {
 				max_scale_ = max_scale;
-				scale_factor_ = max_scale;
-				UpdateBufScaled();
+				is_built_ = false;
+			}
+
+			/**
+			 * @brief Set the input image, with any row stride.
+			 *
+			 * The image is either gray or 3-channel of the given channel order,
+			 * and is read in place rather than copied, so it must not change until
+			 * detection on it finishes. Color images are converted to gray while
+			 * building the first level, and while reading rows by
+			 * `GetGrayRow1x()`.
+			 */
+			void SetImage1x(const seeta::ImageData & img,
+				ChannelOrder order = kChannelBGR);
+
+			/**
+			 * @brief Restrict detection to the allowed regions of `mask`.
+			 *
+			 * The mask is not copied and must outlive the detection. It is reset
+			 * by `SetImage1x()`; nullptr means the whole image.
+			 */
+			inline void SetMask(const seeta::fd::DetectionMask* mask) {
+				mask_ = mask;
 			}
 
-			void SetImage1x(const uint8_t* img_data, int32_t width, int32_t height);
+			inline const seeta::fd::DetectionMask* mask() const { return mask_; }
+
+			/**
+			 * @brief Limit the time spent on detecting faces on the image.
+			 *
+			 * Not owned, and reset by `SetImage1x()`; nullptr means no limit.
+			 */
+			inline void SetTimeBudget(seeta::fd::TimeBudget* time_budget) {
+				time_budget_ = time_budget;
+			}
+
+			inline seeta::fd::TimeBudget* time_budget() const {
+				return time_budget_;
+			}
+
+			/**
+			 * @brief Record the stats of the detection on the image.
+			 *
+			 * Not owned, and reset by `SetImage1x()`; nullptr means no stats.
+			 */
+			inline void SetStatsRecorder(seeta::fd::StatsRecorder* stats_recorder) {
+				stats_recorder_ = stats_recorder;
+			}
+
+			inline seeta::fd::StatsRecorder* stats_recorder() const {
+				return stats_recorder_;
+			}
 
 			inline float min_scale() const { return min_scale_; }
 			inline float max_scale() const { return max_scale_; }
+			inline float scale_step() const { return scale_step_; }
 
-			inline seeta::ImageData image1x() {
-				seeta::ImageData img(width1x_, height1x_, 1);
-				img.data = buf_img_;
+			inline seeta::ImageData image1x() const {
+				seeta::ImageData img(width1x_, height1x_, img1x_channels_);
+				img.data = const_cast<uint8_t*>(img1x_data_);
+				img.stride = img1x_stride_;
 				return img;
 			}
 
-			const seeta::ImageData* GetNextScaleImage(float* scale_factor = nullptr);
+			/**
+			 * @brief Copy `len` pixels of row `y` of the 1x image, starting from
+			 * column `x`, to `dest` in gray.
+			 */
+			inline void GetGrayRow1x(int32_t x, int32_t y, int32_t len,
+				uint8_t* dest) const {
+				ConvertRowToGray(img1x_data_ + y * img1x_stride_ + x * img1x_channels_,
+					len, img1x_channels_, channel_order_, dest);
+			}
 
-		private:
-			void UpdateBufScaled();
+			/**
+			 * @brief Number of levels between the max and the min scale.
+			 */
+			int32_t GetNumScales() const;
+
+			/**
+			 * @brief Scale factor of the given level, level 0 being the max scale.
+			 */
+			float GetScale(int32_t level) const;
+
+			/**
+			 * @brief Size of the image at the given level.
+			 */
+			void GetScaleSize(int32_t level, int32_t* width, int32_t* height) const;
+
+			/**
+			 * @brief Build the images of all levels in one pass.
+			 *
+			 * Level 0 is resized from the 1x image and every other level from the
+			 * level above it, which is much smaller than the 1x image for all but the
+			 * first levels. Nothing is done if the levels are already up to date.
+			 */
+			void BuildScaleImages();
+
+			/**
+			 * @brief Image of the given level, valid after `BuildScaleImages()`.
+			 *
+			 * The pixels stay owned by the pyramid, so several threads can read
+			 * different levels, or different rows of a level, at the same time.
+			 */
+			inline seeta::ImageData GetScaleImage(int32_t level) const {
+				return img_scaled_[level];
+			}
 
+			/** Whether the images of all levels are up to date */
+			inline bool is_built() const { return is_built_; }
+
+			/**
+			 * @brief Pixels of `rect` on the given level, written to `dest` of the
+			 * size of `rect`.
+			 *
+			 * They are copied from the level once built, and otherwise resized from
+			 * the 1x image by `resizer` without building anything, which reads the
+			 * part of the 1x image under `rect` only. The latter may differ slightly
+			 * from the built level, which is resized from the level above it.
+			 */
+			void GetScaleRegion(int32_t level, const seeta::Rect & rect,
+				seeta::fd::ImageResizer* resizer, seeta::ImageData* dest) const;
+
+		private:
 			float max_scale_;
 			float min_scale_;
-
-			float scale_factor_;
 			float scale_step_;
 
 			int32_t width1x_;
 			int32_t height1x_;
 
-			int32_t width_scaled_;
-			int32_t height_scaled_;
+			const uint8_t* img1x_data_;
+			int32_t img1x_stride_;
+			int32_t img1x_channels_;
+			ChannelOrder channel_order_;
 
-			uint8_t* buf_img_;
-			int32_t buf_img_width_;
-			int32_t buf_img_height_;
+			std::vector<uint8_t> buf_img_scaled_;
+			std::vector<seeta::ImageData> img_scaled_;
+			bool is_built_;
 
-			uint8_t* buf_img_scaled_;
-			int32_t buf_scaled_width_;
-			int32_t buf_scaled_height_;
+			const seeta::fd::DetectionMask* mask_;
+			seeta::fd::TimeBudget* time_budget_;
+			seeta::fd::StatsRecorder* stats_recorder_;
 
-			seeta::ImageData img_scaled_;
+			seeta::fd::ImageResizer resizer_;
 		};
 
 	}  // namespace fd
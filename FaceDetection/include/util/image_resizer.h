@@ -0,0 +1,114 @@
+/*
+ *
+ * This file is part of the open-source SeetaFace engine, which includes three modules:
+ * SeetaFace Detection, SeetaFace Alignment, and SeetaFace Identification.
+ *
+ * This file is part of the SeetaFace Detection module, containing codes implementing the
+ * face detection method described in the following paper:
+ *
+ *
+ *   Funnel-structured cascade for multi-view face detection with alignment awareness,
+ *   Shuzhe Wu, Meina Kan, Zhenliang He, Shiguang Shan, Xilin Chen.
+ *   In Neurocomputing (under review)
+ *
+ *
+ * Copyright (C) 2016, Visual Information Processing and Learning (VIPL) group,
+ * Institute of Computing Technology, Chinese Academy of Sciences, Beijing, China.
+ *
+ * The codes are mainly developed by Shuzhe Wu (a Ph.D supervised by Prof. Shiguang Shan)
+ *
+ * As an open-source face recognition engine: you can redistribute SeetaFace source codes
+ * and/or modify it under the terms of the BSD 2-Clause License.
+ *
+ * You should have received a copy of the BSD 2-Clause License along with the software.
+ * If not, see < https://opensource.org/licenses/BSD-2-Clause>.
+ *
+ * Contact Info: you can send an email to SeetaFace@vipl.ict.ac.cn for any problems.
+ *
+ * Note: the above information must be kept whenever or wherever the codes are used.
+ *
+ */
+
+
+#ifndef SEETA_FD_UTIL_IMAGE_RESIZER_H_
+#define SEETA_FD_UTIL_IMAGE_RESIZER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "common.h"
+#include "util/color_converter.h"
+#include "util/simd_kernels.h"
+
+namespace seeta {
+namespace fd {
+
+/**
+ * @class ImageResizer
+ * @brief Bilinear image resizing with fixed-point weights.
+ *
+ * The source position and the interpolation weight of every destination
+ * column and row are tabulated once per call, with weights stored in
+ * `kResizeWeightBits` bits. Each source row is interpolated horizontally at
+ * most once, and the two rows around a destination row are then blended,
+ * both by the SIMD kernels bound for the CPU. Results may differ from
+ * `ResizeImage()` by one gray level.
+ *
+ * A 3-channel source is converted to gray row by row as the rows are read,
+ * so that only the rows sampled by the destination are ever converted.
+ *
+ * A region of the destination can be computed alone, reading only the part
+ * of the source under it, and comes out the same as the pixels of the region
+ * in the whole destination.
+ *
+ * A source one pixel wide or high is stretched, its single column or row
+ * being replicated.
+ */
+class ImageResizer {
+ public:
+  ImageResizer() {}
+  ~ImageResizer() {}
+
+  /**
+   * Resize `src`, either gray or 3-channel of the given channel order, to the
+   * size of the gray image `dest`.
+   */
+  void Resize(const seeta::ImageData & src, seeta::ImageData* dest,
+    ChannelOrder order = kChannelBGR);
+
+  /**
+   * Same as above for the pixels of `rect` of a destination of size
+   * `dest_width` x `dest_height`, written to `dest` of the size of `rect`.
+   */
+  void ResizeRegion(const seeta::ImageData & src, int32_t dest_width,
+    int32_t dest_height, const seeta::Rect & rect, seeta::ImageData* dest,
+    ChannelOrder order = kChannelBGR);
+
+ private:
+  /**
+   * Row `y` of `src` in gray, converted into `gray_row_` if needed, in which
+   * case only the columns read by `x_offset_` are valid
+   */
+  const uint8_t* GetGrayRow(const seeta::ImageData & src, int32_t y,
+    ChannelOrder order);
+  /** Tables of the `len` destination positions starting at `begin` */
+  void ComputeTable(int32_t src_len, int32_t dest_len, int32_t begin,
+    int32_t len, std::vector<int32_t>* offset, std::vector<int32_t>* weight);
+  /** Horizontal interpolation of one source row into `dest` */
+  void InterpolateRow(const uint8_t* src, int32_t src_width,
+    int32_t* dest) const;
+
+  std::vector<int32_t> x_offset_;
+  std::vector<int32_t> x_weight_;
+  std::vector<int32_t> y_offset_;
+  std::vector<int32_t> y_weight_;
+  std::vector<int32_t> row_buf_[2];
+  std::vector<uint8_t> gray_row_;  /**< source row converted to gray */
+
+  DISABLE_COPY_AND_ASSIGN(ImageResizer);
+};
+
+}  // namespace fd
+}  // namespace seeta
+
+#endif  // SEETA_FD_UTIL_IMAGE_RESIZER_H_
@@ -0,0 +1,115 @@
+/*
+ *
+ * This file is part of the open-source SeetaFace engine, which includes three modules:
+ * SeetaFace Detection, SeetaFace Alignment, and SeetaFace Identification.
+ *
+ * This file is part of the SeetaFace Detection module, containing codes implementing the
+ * face detection method described in the following paper:
+ *
+ *
+ *   Funnel-structured cascade for multi-view face detection with alignment awareness,
+ *   Shuzhe Wu, Meina Kan, Zhenliang He, Shiguang Shan, Xilin Chen.
+ *   In Neurocomputing (under review)
+ *
+ *
+ * Copyright (C) 2016, Visual Information Processing and Learning (VIPL) group,
+ * Institute of Computing Technology, Chinese Academy of Sciences, Beijing, China.
+ *
+ * The codes are mainly developed by Shuzhe Wu (a Ph.D supervised by Prof. Shiguang Shan)
+ *
+ * As an open-source face recognition engine: you can redistribute SeetaFace source codes
+ * and/or modify it under the terms of the BSD 2-Clause License.
+ *
+ * You should have received a copy of the BSD 2-Clause License along with the software.
+ * If not, see < https://opensource.org/licenses/BSD-2-Clause>.
+ *
+ * Contact Info: you can send an email to SeetaFace@vipl.ict.ac.cn for any problems.
+ *
+ * Note: the above information must be kept whenever or wherever the codes are used.
+ *
+ */
+
+
+#ifndef SEETA_FD_UTIL_MOTION_DETECTOR_H_
+#define SEETA_FD_UTIL_MOTION_DETECTOR_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "common.h"
+#include "util/color_converter.h"
+
+namespace seeta {
+namespace fd {
+
+/**
+ * @class MotionDetector
+ * @brief Find the blocks of a video frame that changed from the background.
+ *
+ * Frames are reduced by averaging `kDownsample` x `kDownsample` pixels and
+ * compared with a background model of the same size, which is blended with
+ * every frame. A block of `block_size()` x `block_size()` pixels changes when
+ * the mean absolute difference of its reduced pixels from the background
+ * exceeds a threshold. Changed blocks are grown by one block on each side, so
+ * that faces only partially in a changed block are still covered. 3-channel
+ * frames are reduced in gray, taken as BGR since the channel order hardly
+ * matters for finding changes.
+ */
+class MotionDetector {
+ public:
+  MotionDetector()
+      : thresh_(4), width_(0), height_(0), num_block_x_(0), num_block_y_(0),
+        num_changed_(0) {}
+  ~MotionDetector() {}
+
+  /** Set the mean absolute difference over which a block changes. */
+  inline void SetThreshold(int32_t thresh) { thresh_ = thresh; }
+
+  /**
+   * Compare `img` with the background and blend it into the background.
+   * Returns false, with all blocks changed, when there is no background of
+   * the size of `img` yet.
+   */
+  bool Update(const seeta::ImageData & img);
+
+  /** Whether any block overlapping `rect` changed */
+  bool IsChanged(const seeta::Rect & rect) const;
+
+  inline int32_t block_size() const { return kDownsample * kBlockCell; }
+  inline int32_t num_block_x() const { return num_block_x_; }
+  inline int32_t num_block_y() const { return num_block_y_; }
+  inline int32_t num_changed() const { return num_changed_; }
+
+  /** One byte per block, nonzero for the changed ones, row by row */
+  inline const uint8_t* changed() const { return changed_.data(); }
+
+ private:
+  static const int32_t kDownsample = 4;
+  static const int32_t kBlockCell = 8;  /**< block size in reduced pixels */
+
+  void Downsample(const seeta::ImageData & img);
+  void ComputeBlockDiff();
+  void DilateChanged();
+
+  int32_t thresh_;
+  int32_t width_;
+  int32_t height_;
+  int32_t num_block_x_;
+  int32_t num_block_y_;
+  int32_t num_changed_;
+
+  std::vector<uint8_t> frame_;       /**< reduced frame */
+  std::vector<uint8_t> background_;  /**< reduced background model */
+  std::vector<int32_t> block_diff_;
+  std::vector<uint8_t> changed_;
+  std::vector<uint8_t> changed_buf_;
+  std::vector<int16_t> row_sum_;
+  std::vector<uint8_t> gray_rows_;   /**< rows of a 3-channel frame in gray */
+
+  DISABLE_COPY_AND_ASSIGN(MotionDetector);
+};
+
+}  // namespace fd
+}  // namespace seeta
+
+#endif  // SEETA_FD_UTIL_MOTION_DETECTOR_H_
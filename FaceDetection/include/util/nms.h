@@ -39,9 +39,24 @@
 namespace seeta {
 namespace fd {
 
+/**
+ * @brief Greedily select boxes in decreasing order of score, merging into
+ * each selected box the remaining ones overlapping it by more than
+ * `iou_thresh`, whose scores are added to it.
+ *
+ * Large inputs are bucketed by box size and position so that only nearby
+ * boxes of comparable size are compared, which gives the same result as
+ * comparing all pairs in near-linear time.
+ */
 void NonMaximumSuppression(std::vector<seeta::FaceInfo>* bboxes,
   std::vector<seeta::FaceInfo>* bboxes_nms, float iou_thresh = 0.8f);
 
+/**
+ * @brief Same as `NonMaximumSuppression()`, comparing all pairs of boxes.
+ */
+void NonMaximumSuppressionPairwise(std::vector<seeta::FaceInfo>* bboxes,
+  std::vector<seeta::FaceInfo>* bboxes_nms, float iou_thresh = 0.8f);
+
 }  // namespace fd
 }  // namespace seeta
 
@@ -0,0 +1,77 @@
+/*
+ *
+ * This file is part of the open-source SeetaFace engine, which includes three modules:
+ * SeetaFace Detection, SeetaFace Alignment, and SeetaFace Identification.
+ *
+ * This file is part of the SeetaFace Detection module, containing codes implementing the
+ * face detection method described in the following paper:
+ *
+ *
+ *   Funnel-structured cascade for multi-view face detection with alignment awareness,
+ *   Shuzhe Wu, Meina Kan, Zhenliang He, Shiguang Shan, Xilin Chen.
+ *   In Neurocomputing (under review)
+ *
+ *
+ * Copyright (C) 2016, Visual Information Processing and Learning (VIPL) group,
+ * Institute of Computing Technology, Chinese Academy of Sciences, Beijing, China.
+ *
+ * The codes are mainly developed by Shuzhe Wu (a Ph.D supervised by Prof. Shiguang Shan)
+ *
+ * As an open-source face recognition engine: you can redistribute SeetaFace source codes
+ * and/or modify it under the terms of the BSD 2-Clause License.
+ *
+ * You should have received a copy of the BSD 2-Clause License along with the software.
+ * If not, see < https://opensource.org/licenses/BSD-2-Clause>.
+ *
+ * Contact Info: you can send an email to SeetaFace@vipl.ict.ac.cn for any problems.
+ *
+ * Note: the above information must be kept whenever or wherever the codes are used.
+ *
+ */
+
+
+
+#ifndef SEETA_FD_UTIL_PARALLEL_FOR_H_
+#define SEETA_FD_UTIL_PARALLEL_FOR_H_
+
+#include <algorithm>
+#include <cstdint>
+
+#include "executor.h"
+
+namespace seeta {
+namespace fd {
+
+/**
+ * @brief Call `body(i)` for each i in [begin, end), split into one chunk of
+ *        consecutive indices per thread of `executor`.
+ *
+ * Runs inline when `executor` is nullptr or has a single thread, which is
+ * the case of loops run from inside the tasks of an executor.
+ */
+template <typename Body>
+void ParallelFor(seeta::Executor* executor, int32_t begin, int32_t end,
+    const Body & body) {
+  int32_t len = end - begin;
+  int32_t num_chunk = (executor != nullptr ?
+    std::min(executor->num_threads(), len) : 1);
+  if (num_chunk <= 1) {
+    for (int32_t i = begin; i < end; i++)
+      body(i);
+    return;
+  }
+
+  executor->ParallelFor(num_chunk, [&](int32_t k) {
+    int32_t chunk_begin = begin +
+      static_cast<int32_t>(static_cast<int64_t>(len) * k / num_chunk);
+    int32_t chunk_end = begin +
+      static_cast<int32_t>(static_cast<int64_t>(len) * (k + 1) / num_chunk);
+    for (int32_t i = chunk_begin; i < chunk_end; i++)
+      body(i);
+  });
+}
+
+}  // namespace fd
+}  // namespace seeta
+
+#endif  // SEETA_FD_UTIL_PARALLEL_FOR_H_
@@ -0,0 +1,134 @@
+/*
+ *
+ * This file is part of the open-source SeetaFace engine, which includes three modules:
+ * SeetaFace Detection, SeetaFace Alignment, and SeetaFace Identification.
+ *
+ * This file is part of the SeetaFace Detection module, containing codes implementing the
+ * face detection method described in the following paper:
+ *
+ *
+ *   Funnel-structured cascade for multi-view face detection with alignment awareness,
+ *   Shuzhe Wu, Meina Kan, Zhenliang He, Shiguang Shan, Xilin Chen.
+ *   In Neurocomputing (under review)
+ *
+ *
+ * Copyright (C) 2016, Visual Information Processing and Learning (VIPL) group,
+ * Institute of Computing Technology, Chinese Academy of Sciences, Beijing, China.
+ *
+ * The codes are mainly developed by Shuzhe Wu (a Ph.D supervised by Prof. Shiguang Shan)
+ *
+ * As an open-source face recognition engine: you can redistribute SeetaFace source codes
+ * and/or modify it under the terms of the BSD 2-Clause License.
+ *
+ * You should have received a copy of the BSD 2-Clause License along with the software.
+ * If not, see < https://opensource.org/licenses/BSD-2-Clause>.
+ *
+ * Contact Info: you can send an email to SeetaFace@vipl.ict.ac.cn for any problems.
+ *
+ * Note: the above information must be kept whenever or wherever the codes are used.
+ *
+ */
+
+
+
+#ifndef SEETA_FD_UTIL_SIMD_KERNELS_H_
+#define SEETA_FD_UTIL_SIMD_KERNELS_H_
+
+#include <cstdint>
+
+namespace seeta {
+namespace fd {
+
+/** Bits of the fixed-point weights of the resize kernels */
+const int32_t kResizeWeightBits = 11;
+
+/**
+ * Bits of the LAB code set by the comparisons with the eight neighbouring
+ * rectangles, at the offsets `black_offset` of `lab_code_row`.
+ */
+const int32_t kLABCodeBit[8] = {
+  0x80, 0x40, 0x20, 0x08, 0x01, 0x02, 0x04, 0x10
+};
+
+/**
+ * @brief Kernels with variants for several instruction sets, bound once to
+ *        the best ones the CPU supports.
+ *
+ * The baseline variants use SSE4.1 when built with `USE_SSE`, and plain C++
+ * otherwise. AVX2 and AVX-512 ones are built in their own translation units,
+ * with `USE_AVX2` and `USE_AVX512`, and only used after checking the CPU. All
+ * variants of a kernel give the same results.
+ */
+typedef struct SIMDKernels {
+  /** Name of the widest instruction set in use, for reports */
+  const char* isa;
+
+  /** z = x + y and z = x - y, elementwise */
+  void (*vector_add)(const int32_t* x, const int32_t* y, int32_t* z,
+    int32_t len);
+  void (*vector_sub)(const int32_t* x, const int32_t* y, int32_t* z,
+    int32_t len);
+  void (*vector_abs)(const int32_t* src, int32_t* dest, int32_t len);
+  void (*square)(const int32_t* src, uint32_t* dest, int32_t len);
+  /**
+   * Inner product, summed in 4 lanes as `MLPLayer` does, so that it has no
+   * wider variants.
+   */
+  float (*vector_inner_product)(const float* x, const float* y, int32_t len);
+  /**
+   * Inner products of the 4 int16 rows `x[0..3]` with the int8 row `w`, `len`
+   * being a multiple of 16.
+   */
+  void (*inner_product_block_int8)(const int16_t* const* x, const int8_t* w,
+    int32_t len, int32_t* prod);
+
+  /**
+   * Horizontal interpolation of the row `src` at `dest_width` positions,
+   * `dest[x]` lying between `src[offset[x]]` and `src[offset[x] + 1]` with
+   * weight `weight[x]`, scaled by 2^kResizeWeightBits.
+   */
+  void (*resize_interpolate_row)(const uint8_t* src, int32_t src_width,
+    const int32_t* offset, const int32_t* weight, int32_t* dest,
+    int32_t dest_width);
+  /** Vertical interpolation between two rows of the above, to 8 bits */
+  void (*resize_blend_rows)(const int32_t* row0, const int32_t* row1,
+    int32_t weight, uint8_t* dest, int32_t len);
+
+  /**
+   * LAB codes of `len` consecutive positions, comparing the rectangle sums
+   * `white[c]` with `black[c + black_offset[i]]`.
+   */
+  void (*lab_code_row)(const int32_t* white, const int32_t* black,
+    const int32_t* black_offset, uint8_t* dest, int32_t len);
+  /**
+   * One group of `num_feat` LAB base classifiers over the `num_alive`
+   * windows `wnd_idx`, whose top left corners lie at `wnd_offset[wnd_idx[k]]`
+   * of `feat_val`. Base classifier j reads the feature at offset
+   * `feat_offset[j]` of the window and the weight at `j * weight_stride` of
+   * `weights`. Windows scoring below `thresh` are dropped, the others kept
+   * in place and in order, and their number returned.
+   */
+  int32_t (*lab_classify_group)(const uint8_t* feat_val,
+    const int32_t* wnd_offset, const int32_t* feat_offset, int32_t num_feat,
+    const float* weights, int32_t weight_stride, float thresh,
+    int32_t num_alive, int32_t* wnd_idx, float* wnd_score);
+  int32_t (*lab_classify_group_int16)(const uint8_t* feat_val,
+    const int32_t* wnd_offset, const int32_t* feat_offset, int32_t num_feat,
+    const int16_t* weights, int32_t weight_stride, float thresh,
+    int32_t num_alive, int32_t* wnd_idx, float* wnd_score);
+} SIMDKernels;
+
+/** Kernels for the running CPU, bound on first use */
+const SIMDKernels & GetSIMDKernels();
+
+/**
+ * Override the kernels of `kernels` having AVX2 or AVX-512 variants. The CPU
+ * must support the instruction set.
+ */
+void BindAVX2Kernels(SIMDKernels* kernels);
+void BindAVX512Kernels(SIMDKernels* kernels);
+
+}  // namespace fd
+}  // namespace seeta
+
+#endif  // SEETA_FD_UTIL_SIMD_KERNELS_H_
@@ -0,0 +1,139 @@
+/*
+ *
+ * This file is part of the open-source SeetaFace engine, which includes three modules:
+ * SeetaFace Detection, SeetaFace Alignment, and SeetaFace Identification.
+ *
+ * This file is part of the SeetaFace Detection module, containing codes implementing the
+ * face detection method described in the following paper:
+ *
+ *
+ *   Funnel-structured cascade for multi-view face detection with alignment awareness,
+ *   Shuzhe Wu, Meina Kan, Zhenliang He, Shiguang Shan, Xilin Chen.
+ *   In Neurocomputing (under review)
+ *
+ *
+ * Copyright (C) 2016, Visual Information Processing and Learning (VIPL) group,
+ * Institute of Computing Technology, Chinese Academy of Sciences, Beijing, China.
+ *
+ * The codes are mainly developed by Shuzhe Wu (a Ph.D supervised by Prof. Shiguang Shan)
+ *
+ * As an open-source face recognition engine: you can redistribute SeetaFace source codes
+ * and/or modify it under the terms of the BSD 2-Clause License.
+ *
+ * You should have received a copy of the BSD 2-Clause License along with the software.
+ * If not, see < https://opensource.org/licenses/BSD-2-Clause>.
+ *
+ * Contact Info: you can send an email to SeetaFace@vipl.ict.ac.cn for any problems.
+ *
+ * Note: the above information must be kept whenever or wherever the codes are used.
+ *
+ */
+
+
+
+#ifndef SEETA_FD_UTIL_STATS_RECORDER_H_
+#define SEETA_FD_UTIL_STATS_RECORDER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "common.h"
+#include "detection_stats.h"
+
+namespace seeta {
+namespace fd {
+
+/**
+ * @class StatsRecorder
+ * @brief Collect the `DetectionStats` of a detection, from any thread.
+ *
+ * Stages of the detector record their counters and times only when a
+ * recorder is set, keeping local sums and adding them here once per band of
+ * a level or per stage, so that an unused recorder costs nothing.
+ */
+class StatsRecorder {
+ public:
+  /** Reset `stats` and start counting the time of the detection */
+  explicit StatsRecorder(seeta::DetectionStats* stats)
+      : stats_(stats), start_(std::chrono::steady_clock::now()) {
+    *stats_ = seeta::DetectionStats();
+  }
+  ~StatsRecorder() {}
+
+  /** Microseconds since the construction of the recorder */
+  inline int64_t GetElapsed() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start_).count();
+  }
+
+  /**
+   * Add the counters and times of `level_stats` to those of the given level,
+   * whose scale and size are taken if not yet set.
+   */
+  void AddLevel(int32_t level,
+      const seeta::DetectionStats::Level & level_stats) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (static_cast<int32_t>(stats_->levels.size()) <= level)
+      stats_->levels.resize(level + 1);
+    seeta::DetectionStats::Level & dest = stats_->levels[level];
+    if (dest.width == 0) {
+      dest.scale = level_stats.scale;
+      dest.width = level_stats.width;
+      dest.height = level_stats.height;
+    }
+    dest.resize_us += level_stats.resize_us;
+    dest.feat_map_us += level_stats.feat_map_us;
+    dest.scan_us += level_stats.scan_us;
+    dest.num_wnd += level_stats.num_wnd;
+    dest.num_probe += level_stats.num_probe;
+    if (dest.num_pass.size() < level_stats.num_pass.size())
+      dest.num_pass.resize(level_stats.num_pass.size(), 0);
+    for (size_t i = 0; i < level_stats.num_pass.size(); i++)
+      dest.num_pass[i] += level_stats.num_pass[i];
+  }
+
+  /** Add `num_in` and `num_out` proposals to the counters of a hierarchy */
+  void AddProposals(int32_t hierarchy, int64_t num_in, int64_t num_out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    seeta::DetectionStats::Hierarchy & dest = GetHierarchy(hierarchy);
+    dest.num_in += num_in;
+    dest.num_out += num_out;
+  }
+
+  /** Add time to the `stage`-th stage of a hierarchy */
+  void AddStageTime(int32_t hierarchy, int32_t stage, int64_t us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    seeta::DetectionStats::Hierarchy & dest = GetHierarchy(hierarchy);
+    if (static_cast<int32_t>(dest.stage_us.size()) <= stage)
+      dest.stage_us.resize(stage + 1, 0);
+    dest.stage_us[stage] += us;
+  }
+
+  /** Add time to the non-maximum suppression of a hierarchy */
+  void AddNMSTime(int32_t hierarchy, int64_t us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    GetHierarchy(hierarchy).nms_us += us;
+  }
+
+  inline seeta::DetectionStats* stats() const { return stats_; }
+
+ private:
+  seeta::DetectionStats::Hierarchy & GetHierarchy(int32_t hierarchy) {
+    if (static_cast<int32_t>(stats_->hierarchies.size()) <= hierarchy)
+      stats_->hierarchies.resize(hierarchy + 1);
+    return stats_->hierarchies[hierarchy];
+  }
+
+  seeta::DetectionStats* stats_;
+  std::chrono::steady_clock::time_point start_;
+  std::mutex mutex_;
+
+  DISABLE_COPY_AND_ASSIGN(StatsRecorder);
+};
+
+}  // namespace fd
+}  // namespace seeta
+
+#endif  // SEETA_FD_UTIL_STATS_RECORDER_H_
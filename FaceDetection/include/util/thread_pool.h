@@ -0,0 +1,116 @@
+/*
+ *
+ * This file is part of the open-source SeetaFace engine, which includes three modules:
+ * SeetaFace Detection, SeetaFace Alignment, and SeetaFace Identification.
+ *
+ * This file is part of the SeetaFace Detection module, containing codes implementing the
+ * face detection method described in the following paper:
+ *
+ *
+ *   Funnel-structured cascade for multi-view face detection with alignment awareness,
+ *   Shuzhe Wu, Meina Kan, Zhenliang He, Shiguang Shan, Xilin Chen.
+ *   In Neurocomputing (under review)
+ *
+ *
+ * Copyright (C) 2016, Visual Information Processing and Learning (VIPL) group,
+ * Institute of Computing Technology, Chinese Academy of Sciences, Beijing, China.
+ *
+ * The codes are mainly developed by Shuzhe Wu (a Ph.D supervised by Prof. Shiguang Shan)
+ *
+ * As an open-source face recognition engine: you can redistribute SeetaFace source codes
+ * and/or modify it under the terms of the BSD 2-Clause License.
+ *
+ * You should have received a copy of the BSD 2-Clause License along with the software.
+ * If not, see < https://opensource.org/licenses/BSD-2-Clause>.
+ *
+ * Contact Info: you can send an email to SeetaFace@vipl.ict.ac.cn for any problems.
+ *
+ * Note: the above information must be kept whenever or wherever the codes are used.
+ *
+ */
+
+
+#ifndef SEETA_FD_UTIL_THREAD_POOL_H_
+#define SEETA_FD_UTIL_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common.h"
+
+namespace seeta {
+namespace fd {
+
+/**
+ * @class ThreadPool
+ * @brief Fixed set of worker threads with work stealing.
+ *
+ * Every worker owns a task deque. It takes tasks from the front of its own
+ * deque and, when that runs dry, steals from the back of the others'.
+ */
+class ThreadPool {
+ public:
+  typedef std::function<void()> Task;
+
+  explicit ThreadPool(int32_t num_threads);
+  ~ThreadPool();
+
+  inline int32_t num_threads() const {
+    return static_cast<int32_t>(threads_.size());
+  }
+
+  /**
+   * @brief Run the tasks and wait until they have finished.
+   *
+   * Tasks are dealt round-robin in the given order, so put the expensive
+   * ones first. Several threads may call this at the same time, tasks
+   * included: a worker waiting for its tasks runs queued ones meanwhile, so
+   * that nested calls cannot leave all workers waiting.
+   */
+  void Run(const std::vector<Task> & tasks);
+
+ private:
+  typedef struct Batch {
+    std::atomic<int32_t> num_pending;
+    std::mutex mutex;
+    std::condition_variable done;
+  } Batch;
+
+  typedef struct Job {
+    Task task;
+    Batch* batch;
+  } Job;
+
+  typedef struct Worker {
+    std::mutex mutex;
+    std::deque<Job> jobs;
+  } Worker;
+
+  void Push(int32_t worker_id, const Job & job);
+  bool Pop(int32_t worker_id, Job* job);
+  void RunJob(Job* job);
+  void WorkerLoop(int32_t worker_id);
+
+  std::vector<std::unique_ptr<Worker> > workers_;
+  std::vector<std::thread> threads_;
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  int32_t num_queued_;
+  int32_t next_worker_;
+  bool stop_;
+
+  DISABLE_COPY_AND_ASSIGN(ThreadPool);
+};
+
+}  // namespace fd
+}  // namespace seeta
+
+#endif  // SEETA_FD_UTIL_THREAD_POOL_H_
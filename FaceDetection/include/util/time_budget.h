@@ -0,0 +1,84 @@
+/*
+ *
+ * This file is part of the open-source SeetaFace engine, which includes three modules:
+ * SeetaFace Detection, SeetaFace Alignment, and SeetaFace Identification.
+ *
+ * This file is part of the SeetaFace Detection module, containing codes implementing the
+ * face detection method described in the following paper:
+ *
+ *
+ *   Funnel-structured cascade for multi-view face detection with alignment awareness,
+ *   Shuzhe Wu, Meina Kan, Zhenliang He, Shiguang Shan, Xilin Chen.
+ *   In Neurocomputing (under review)
+ *
+ *
+ * Copyright (C) 2016, Visual Information Processing and Learning (VIPL) group,
+ * Institute of Computing Technology, Chinese Academy of Sciences, Beijing, China.
+ *
+ * The codes are mainly developed by Shuzhe Wu (a Ph.D supervised by Prof. Shiguang Shan)
+ *
+ * As an open-source face recognition engine: you can redistribute SeetaFace source codes
+ * and/or modify it under the terms of the BSD 2-Clause License.
+ *
+ * You should have received a copy of the BSD 2-Clause License along with the software.
+ * If not, see < https://opensource.org/licenses/BSD-2-Clause>.
+ *
+ * Contact Info: you can send an email to SeetaFace@vipl.ict.ac.cn for any problems.
+ *
+ * Note: the above information must be kept whenever or wherever the codes are used.
+ *
+ */
+
+
+#ifndef SEETA_FD_UTIL_TIME_BUDGET_H_
+#define SEETA_FD_UTIL_TIME_BUDGET_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "common.h"
+
+namespace seeta {
+namespace fd {
+
+/**
+ * @class TimeBudget
+ * @brief Time allowed for detecting faces on an image, counted from the
+ * construction of the object.
+ *
+ * Stages of the detector that skip work to stay within the budget mark the
+ * result as partial. Marking is safe from several threads at once.
+ */
+class TimeBudget {
+ public:
+  explicit TimeBudget(int64_t budget_us)
+      : start_(std::chrono::steady_clock::now()), budget_us_(budget_us),
+        is_partial_(false) {}
+  ~TimeBudget() {}
+
+  /** Time since the start, in microseconds */
+  inline int64_t GetElapsed() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start_).count();
+  }
+
+  inline int64_t GetRemaining() const { return budget_us_ - GetElapsed(); }
+
+  inline void SetPartial() { is_partial_ = true; }
+
+  inline int64_t budget() const { return budget_us_; }
+  inline bool is_partial() const { return is_partial_; }
+
+ private:
+  std::chrono::steady_clock::time_point start_;
+  int64_t budget_us_;
+  std::atomic<bool> is_partial_;
+
+  DISABLE_COPY_AND_ASSIGN(TimeBudget);
+};
+
+}  // namespace fd
+}  // namespace seeta
+
+#endif  // SEETA_FD_UTIL_TIME_BUDGET_H_
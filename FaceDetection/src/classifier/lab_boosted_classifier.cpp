@@ -29,33 +29,107 @@
  *
  */
 
+
 #include "classifier/lab_boosted_classifier.h"
 
+#include <cmath>
 #include <memory>
 #include <string>
 
+#include "util/simd_kernels.h"
+
 namespace seeta {
 namespace fd {
 
-void LABBaseClassifier::SetWeights(const float* weights, int32_t num_bin) {
-  weights_.resize(num_bin + 1);
+/** The kernel running one group of base classifiers, by weight type */
+static inline int32_t ClassifyGroup(const seeta::fd::SIMDKernels & kernels,
+    const uint8_t* feat_val, const int32_t* wnd_offset,
+    const int32_t* feat_offset, int32_t num_feat, const float* weights,
+    int32_t weight_stride, float thresh, int32_t num_alive, int32_t* wnd_idx,
+    float* wnd_score) {
+  return kernels.lab_classify_group(feat_val, wnd_offset, feat_offset,
+    num_feat, weights, weight_stride, thresh, num_alive, wnd_idx, wnd_score);
+}
+
+static inline int32_t ClassifyGroup(const seeta::fd::SIMDKernels & kernels,
+    const uint8_t* feat_val, const int32_t* wnd_offset,
+    const int32_t* feat_offset, int32_t num_feat, const int16_t* weights,
+    int32_t weight_stride, float thresh, int32_t num_alive, int32_t* wnd_idx,
+    float* wnd_score) {
+  return kernels.lab_classify_group_int16(feat_val, wnd_offset, feat_offset,
+    num_feat, weights, weight_stride, thresh, num_alive, wnd_idx, wnd_score);
+}
+
+void LABModelTable::Reset(int32_t num_base, int32_t num_bin) {
+  num_base_ = num_base;
   num_bin_ = num_bin;
-  std::copy(weights, weights + num_bin_ + 1, weights_.begin());
+  weight_stride_ = static_cast<int32_t>(
+    AlignSize((num_bin + 1) * sizeof(float)) / sizeof(float));
+
+  size_t thresh_len = AlignSize(num_base * sizeof(float));
+  size_t feat_len = AlignSize(num_base * sizeof(seeta::fd::LABFeature));
+  size_t weight_len = AlignSize(num_base * weight_stride_ * sizeof(float));
+  uint8_t* buf = AlignedBuffer(&buf_, thresh_len + feat_len + weight_len);
+
+  thresh_ = reinterpret_cast<float*>(buf);
+  feat_ = reinterpret_cast<seeta::fd::LABFeature*>(buf + thresh_len);
+  weights_ = reinterpret_cast<float*>(buf + thresh_len + feat_len);
+
+  buf_int16_.clear();
+  thresh_int16_ = nullptr;
+  weights_int16_ = nullptr;
 }
 
-bool LABBoostedClassifier::Classify(float* score, float* outputs) {
-  bool isPos = true;
-  float s = 0.0f;
+void LABModelTable::Quantize() {
+  if (is_quantized())
+    return;
 
-  for (size_t i = 0; isPos && i < base_classifiers_.size();) {
-    for (int32_t j = 0; j < kFeatGroupSize; j++, i++) {
-      uint8_t featVal = feat_map_->GetFeatureVal(feat_[i].x, feat_[i].y);
-      s += base_classifiers_[i]->weights(featVal);
+  float max_weight = 0.0f;
+  for (int32_t i = 0; i < num_base_; i++) {
+    for (int32_t j = 0; j <= num_bin_; j++)
+      max_weight = std::max(max_weight, std::fabs(weights_[i * weight_stride_ + j]));
+  }
+  scale_ = (max_weight > 0.0f ? 32767.0f / max_weight : 1.0f);
+
+  // The weight table is padded as 32-bit gathers read 2 bytes past an entry
+  size_t thresh_len = AlignSize(num_base_ * sizeof(float));
+  size_t weight_len = AlignSize(num_base_ * weight_stride_ * sizeof(int16_t) +
+    sizeof(int16_t));
+  uint8_t* buf = AlignedBuffer(&buf_int16_, thresh_len + weight_len);
+  float* thresh = reinterpret_cast<float*>(buf);
+  int16_t* weights = reinterpret_cast<int16_t*>(buf + thresh_len);
+
+  for (int32_t i = 0; i < num_base_; i++) {
+    thresh[i] = static_cast<float>(std::floor(thresh_[i] * scale_ + 0.5));
+    for (int32_t j = 0; j < weight_stride_; j++) {
+      weights[i * weight_stride_ + j] = static_cast<int16_t>(
+        std::floor(weights_[i * weight_stride_ + j] * scale_ + 0.5));
     }
-    if (s < base_classifiers_[i - 1]->threshold())
-      isPos = false;
   }
-  isPos = isPos && ((!use_std_dev_) || feat_map_->GetStdDev() > kStdDevThresh);
+  thresh_int16_ = thresh;
+  weights_int16_ = weights;
+}
+
+uint8_t* LABModelTable::AlignedBuffer(std::vector<uint8_t>* buf, size_t len) {
+  buf->assign(len + kAlignment, 0);
+  size_t addr = reinterpret_cast<size_t>(buf->data());
+  return buf->data() + (kAlignment - addr % kAlignment) % kAlignment;
+}
+
+bool LABBoostedClassifier::Classify(seeta::fd::FeatureMap* feat_map,
+    float* score, float* outputs) const {
+  const seeta::fd::LABFeatureMap* lab_feat_map =
+    static_cast<const seeta::fd::LABFeatureMap*>(feat_map);
+  float s;
+  bool isPos;
+  if (use_int16_) {
+    isPos = ClassifyWindow(lab_feat_map, table_.weights_int16(),
+      table_.thresh_int16(), &s);
+    s /= table_.scale();
+  } else {
+    isPos = ClassifyWindow(lab_feat_map, table_.weights(), table_.thresh(), &s);
+  }
+  isPos = isPos && ((!use_std_dev_) || lab_feat_map->GetStdDev() > kStdDevThresh);
 
   if (score != nullptr)
     *score = s;
@@ -65,19 +139,117 @@ bool LABBoostedClassifier::Classify(float* score, float* outputs) {
   return isPos;
 }
 
-void LABBoostedClassifier::AddFeature(int32_t x, int32_t y) {
-  LABFeature feat;
-  feat.x = x;
-  feat.y = y;
-  feat_.push_back(feat);
+template<typename WeightType>
+bool LABBoostedClassifier::ClassifyWindow(
+    const seeta::fd::LABFeatureMap* feat_map, const WeightType* weights,
+    const float* thresh, float* score) const {
+  const seeta::fd::LABFeature* feat = table_.feat();
+  int32_t num_base = table_.num_base();
+  int32_t weight_stride = table_.weight_stride();
+  bool isPos = true;
+  float s = 0.0f;
+
+  for (int32_t i = 0; isPos && i < num_base;) {
+    for (int32_t j = 0; j < kFeatGroupSize; j++, i++) {
+      uint8_t featVal = feat_map->GetFeatureVal(feat[i].x, feat[i].y);
+      s += static_cast<float>(weights[i * weight_stride + featVal]);
+    }
+    if (s < thresh[i - 1])
+      isPos = false;
+  }
+  *score = s;
+  return isPos;
+}
+
+int32_t LABBoostedClassifier::Classify(
+    const seeta::fd::LABFeatureMap* feat_map, const int32_t* wnd_offset,
+    int32_t num_wnd, int32_t wnd_size, int32_t* wnd_idx,
+    float* wnd_score) const {
+  int32_t num_pos;
+  if (use_int16_) {
+    num_pos = Classify(feat_map, table_.weights_int16(), table_.thresh_int16(),
+      table_.num_base(), 0.0f, wnd_offset, num_wnd, wnd_idx, wnd_score);
+    for (int32_t k = 0; k < num_pos; k++)
+      wnd_score[k] /= table_.scale();
+  } else {
+    num_pos = Classify(feat_map, table_.weights(), table_.thresh(),
+      table_.num_base(), 0.0f, wnd_offset, num_wnd, wnd_idx, wnd_score);
+  }
+
+  if (use_std_dev_) {
+    seeta::Rect roi;
+    int32_t width = feat_map->width();
+    int32_t num_alive = num_pos;
+    num_pos = 0;
+    roi.width = roi.height = wnd_size;
+    for (int32_t k = 0; k < num_alive; k++) {
+      roi.x = wnd_offset[wnd_idx[k]] % width;
+      roi.y = wnd_offset[wnd_idx[k]] / width;
+      if (feat_map->GetStdDev(roi) > kStdDevThresh) {
+        wnd_idx[num_pos] = wnd_idx[k];
+        wnd_score[num_pos] = wnd_score[k];
+        num_pos++;
+      }
+    }
+  }
+
+  return num_pos;
+}
+
+int32_t LABBoostedClassifier::Probe(const seeta::fd::LABFeatureMap* feat_map,
+    const int32_t* wnd_offset, int32_t num_wnd, int32_t num_base, float margin,
+    int32_t* wnd_idx, float* wnd_score) const {
+  num_base = std::min((num_base + kFeatGroupSize - 1) / kFeatGroupSize *
+    kFeatGroupSize, table_.num_base());
+  int32_t num_pos;
+  if (use_int16_) {
+    num_pos = Classify(feat_map, table_.weights_int16(), table_.thresh_int16(),
+      num_base, margin * table_.scale(), wnd_offset, num_wnd, wnd_idx,
+      wnd_score);
+    for (int32_t k = 0; k < num_pos; k++)
+      wnd_score[k] /= table_.scale();
+  } else {
+    num_pos = Classify(feat_map, table_.weights(), table_.thresh(), num_base,
+      margin, wnd_offset, num_wnd, wnd_idx, wnd_score);
+  }
+  return num_pos;
+}
+
+template<typename WeightType>
+int32_t LABBoostedClassifier::Classify(
+    const seeta::fd::LABFeatureMap* feat_map, const WeightType* weights,
+    const float* thresh, int32_t num_base, float margin,
+    const int32_t* wnd_offset, int32_t num_wnd, int32_t* wnd_idx,
+    float* wnd_score) const {
+  const uint8_t* feat_val = feat_map->feat_map();
+  const seeta::fd::LABFeature* feat = table_.feat();
+  int32_t width = feat_map->width();
+  int32_t weight_stride = table_.weight_stride();
+  int32_t num_alive = num_wnd;
+
+  for (int32_t k = 0; k < num_wnd; k++) {
+    wnd_idx[k] = k;
+    wnd_score[k] = 0.0f;
+  }
+
+  const seeta::fd::SIMDKernels & kernels = seeta::fd::GetSIMDKernels();
+  int32_t feat_offset[kFeatGroupSize];
+  for (int32_t i = 0; num_alive > 0 && i < num_base; i += kFeatGroupSize) {
+    int32_t group_end = std::min(i + kFeatGroupSize, num_base);
+    for (int32_t j = i; j < group_end; j++)
+      feat_offset[j - i] = feat[j].y * width + feat[j].x;
+    num_alive = ClassifyGroup(kernels, feat_val, wnd_offset, feat_offset,
+      group_end - i, weights + i * weight_stride, weight_stride,
+      thresh[group_end - 1] - margin, num_alive, wnd_idx, wnd_score);
+  }
+
+  return num_alive;
 }
 
-void LABBoostedClassifier::AddBaseClassifier(const float* weights,
-    int32_t num_bin, float thresh) {
-  std::shared_ptr<LABBaseClassifier> classifier(new LABBaseClassifier());
-  classifier->SetWeights(weights, num_bin);
-  classifier->SetThreshold(thresh);
-  base_classifiers_.push_back(classifier);
+void LABBoostedClassifier::SetUseInt16Weights(bool use) {
+  if (use)
+    table_.Quantize();
+  use_int16_ = use;
 }
 
 }  // namespace fd
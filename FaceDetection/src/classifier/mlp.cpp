@@ -31,33 +31,245 @@
 
 #include "classifier/mlp.h"
 
+#ifdef USE_SSE
+#include <immintrin.h>
+#endif
+
 #include "common.h"
+#include "util/parallel_for.h"
+#include "util/simd_kernels.h"
 
 namespace seeta {
 namespace fd {
 
-void MLPLayer::Compute(const float* input, float* output) {
-#pragma omp parallel num_threads(SEETA_NUM_THREADS)
-  {
-#pragma omp for nowait
+/** Number of inputs sharing each load of a weight row in batch mode */
+static const int32_t kInputBlockSize = 4;
+
+/**
+ * Inner products of `kInputBlockSize` input rows with the weight row `w`.
+ * The accumulation order is that of `MathFunction::VectorInnerProduct()`, so
+ * the results are bit-exact with the single-input path.
+ */
+static inline void InnerProductBlock(const float* x, int32_t x_stride,
+    const float* w, int32_t len, float* prod) {
+  const float* x0 = x;
+  const float* x1 = x0 + x_stride;
+  const float* x2 = x1 + x_stride;
+  const float* x3 = x2 + x_stride;
+  int32_t i;
+#ifdef USE_SSE
+  __m128 z0 = _mm_setzero_ps();
+  __m128 z1 = _mm_setzero_ps();
+  __m128 z2 = _mm_setzero_ps();
+  __m128 z3 = _mm_setzero_ps();
+  __m128 w1;
+  float buf[kInputBlockSize][4];
+
+  for (i = 0; i < len - 4; i += 4) {
+    w1 = _mm_loadu_ps(w + i);
+    z0 = _mm_add_ps(z0, _mm_mul_ps(_mm_loadu_ps(x0 + i), w1));
+    z1 = _mm_add_ps(z1, _mm_mul_ps(_mm_loadu_ps(x1 + i), w1));
+    z2 = _mm_add_ps(z2, _mm_mul_ps(_mm_loadu_ps(x2 + i), w1));
+    z3 = _mm_add_ps(z3, _mm_mul_ps(_mm_loadu_ps(x3 + i), w1));
+  }
+  _mm_storeu_ps(buf[0], z0);
+  _mm_storeu_ps(buf[1], z1);
+  _mm_storeu_ps(buf[2], z2);
+  _mm_storeu_ps(buf[3], z3);
+  for (int32_t k = 0; k < kInputBlockSize; k++)
+    prod[k] = buf[k][0] + buf[k][1] + buf[k][2] + buf[k][3];
+#else
+  prod[0] = prod[1] = prod[2] = prod[3] = 0;
+  i = 0;
+#endif
+  for (; i < len; i++) {
+    prod[0] += x0[i] * w[i];
+    prod[1] += x1[i] * w[i];
+    prod[2] += x2[i] * w[i];
+    prod[3] += x3[i] * w[i];
+  }
+}
+
+void MLPLayer::Compute(const float* input, float* output,
+    seeta::Executor* executor) const {
+  seeta::fd::ParallelFor(executor, 0, output_dim_, [&](int32_t i) {
+    output[i] = seeta::fd::MathFunction::VectorInnerProduct(input,
+      weights_.data() + i * input_dim_, input_dim_) + bias_[i];
+    output[i] = Activate(output[i]);
+  });
+}
+
+void MLPLayer::Compute(const float* input, float* output, int32_t num) const {
+  const float* weights = weights_.data();
+  float prod[kInputBlockSize];
+  int32_t n = 0;
+
+  for (; n + kInputBlockSize <= num; n += kInputBlockSize) {
+    const float* x = input + n * input_dim_;
+    float* y = output + n * output_dim_;
+    for (int32_t i = 0; i < output_dim_; i++) {
+      InnerProductBlock(x, input_dim_, weights + i * input_dim_, input_dim_,
+        prod);
+      for (int32_t k = 0; k < kInputBlockSize; k++)
+        y[k * output_dim_ + i] = Activate(prod[k] + bias_[i]);
+    }
+  }
+  for (; n < num; n++) {
+    const float* x = input + n * input_dim_;
+    float* y = output + n * output_dim_;
+    for (int32_t i = 0; i < output_dim_; i++) {
+      y[i] = Activate(seeta::fd::MathFunction::VectorInnerProduct(x,
+        weights + i * input_dim_, input_dim_) + bias_[i]);
+    }
+  }
+}
+
+/**
+ * Round `x[i] * scale` to int16 for `len` values. Rounding is to nearest even
+ * on all code paths.
+ */
+static inline void QuantizeRow(const float* x, float scale, int32_t len,
+    int16_t* q) {
+  int32_t i = 0;
+#ifdef USE_SSE
+  __m128 s = _mm_set1_ps(scale);
+  for (; i + 8 <= len; i += 8) {
+    __m128i q1 = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(x + i), s));
+    __m128i q2 = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(x + i + 4), s));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(q + i),
+      _mm_packs_epi32(q1, q2));
+  }
+#endif
+  for (; i < len; i++)
+    q[i] = static_cast<int16_t>(std::nearbyint(x[i] * scale));
+}
+
+void MLPLayer::Compute(const float* const* input, const int32_t* part_dim,
+    int32_t num_part, float* output) const {
+  for (int32_t i = 0; i < output_dim_; i++) {
+    const float* weights = weights_.data() + i * input_dim_;
+    float prod = 0;
+    for (int32_t j = 0; j < num_part; j++) {
+      prod += seeta::fd::MathFunction::VectorInnerProduct(input[j], weights,
+        part_dim[j]);
+      weights += part_dim[j];
+    }
+    output[i] = Activate(prod + bias_[i]);
+  }
+}
+
+void MLPLayer::ComputeInt8(const float* input, float* output, int32_t num,
+    int16_t* input_buf, float* input_scale) const {
+  int32_t padded_dim = GetPaddedInputDim();
+  // Keep the int32 sums of `padded_dim` products in range
+  float max_input = std::min(32767.0f, static_cast<float>(std::floor(
+    2147483647.0 / (static_cast<double>(padded_dim) * 127))));
+
+  for (int32_t n = 0; n < num; n++) {
+    const float* x = input + n * input_dim_;
+    int16_t* q = input_buf + n * padded_dim;
+    float max_abs = 0.0f;
+    for (int32_t j = 0; j < input_dim_; j++)
+      max_abs = std::max(max_abs, std::fabs(x[j]));
+    input_scale[n] = (max_abs > 0.0f ? max_input / max_abs : 1.0f);
+    QuantizeRow(x, input_scale[n], input_dim_, q);
+    std::fill(q + input_dim_, q + padded_dim, static_cast<int16_t>(0));
+  }
+
+  const seeta::fd::SIMDKernels & kernels = seeta::fd::GetSIMDKernels();
+  const int16_t* x[kInputBlockSize];
+  int32_t prod[kInputBlockSize];
+  for (int32_t n = 0; n < num; n += kInputBlockSize) {
+    // The last block repeats its last row, whose extra results are dropped
+    int32_t block_size = std::min(kInputBlockSize, num - n);
+    for (int32_t k = 0; k < kInputBlockSize; k++)
+      x[k] = input_buf + (n + std::min(k, block_size - 1)) * padded_dim;
     for (int32_t i = 0; i < output_dim_; i++) {
-      output[i] = seeta::fd::MathFunction::VectorInnerProduct(input,
-        weights_.data() + i * input_dim_, input_dim_) + bias_[i];
-      output[i] = (act_func_type_ == 1 ? ReLU(output[i]) : Sigmoid(-output[i]));
+      kernels.inner_product_block_int8(x,
+        weights_int8_.data() + i * padded_dim, padded_dim, prod);
+      for (int32_t k = 0; k < block_size; k++) {
+        output[(n + k) * output_dim_ + i] = Activate(prod[k] /
+          (input_scale[n + k] * weight_scale_[i]) + bias_[i]);
+      }
     }
   }
 }
 
-void MLP::Compute(const float* input, float* output) {
-  layer_buf_[0].resize(layers_[0]->GetOutputDim());
-  layers_[0]->Compute(input, layer_buf_[0].data());
+void MLPLayer::Quantize() {
+  if (is_quantized())
+    return;
+
+  int32_t padded_dim = GetPaddedInputDim();
+  weight_scale_.resize(output_dim_);
+  weights_int8_.assign(static_cast<size_t>(output_dim_) * padded_dim, 0);
+  for (int32_t i = 0; i < output_dim_; i++) {
+    const float* weights = weights_.data() + i * input_dim_;
+    float max_weight = 0.0f;
+    for (int32_t j = 0; j < input_dim_; j++)
+      max_weight = std::max(max_weight, std::fabs(weights[j]));
+    weight_scale_[i] = (max_weight > 0.0f ? 127.0f / max_weight : 1.0f);
+    for (int32_t j = 0; j < input_dim_; j++) {
+      weights_int8_[i * padded_dim + j] = static_cast<int8_t>(
+        std::floor(weights[j] * weight_scale_[i] + 0.5f));
+    }
+  }
+}
+
+void MLP::Compute(const float* input, float* output, float* buf,
+    seeta::Executor* executor) const {
+  float* layer_buf[2] = { buf, buf + buf_size_ / 2 };
+  layers_[0]->Compute(input, layer_buf[0], executor);
 
   size_t i; /**< layer index */
-  for (i = 1; i < layers_.size() - 1; i++) {
-    layer_buf_[i % 2].resize(layers_[i]->GetOutputDim());
-    layers_[i]->Compute(layer_buf_[(i + 1) % 2].data(), layer_buf_[i % 2].data());
+  for (i = 1; i < layers_.size() - 1; i++)
+    layers_[i]->Compute(layer_buf[(i + 1) % 2], layer_buf[i % 2], executor);
+  layers_.back()->Compute(layer_buf[(i + 1) % 2], output, executor);
+}
+
+void MLP::Compute(const float* input, float* output, int32_t num,
+    float* buf) const {
+  float* layer_buf[2] = { buf, buf + num * (buf_size_ / 2) };
+  if (use_int8_) {
+    int16_t* quant_buf = reinterpret_cast<int16_t*>(buf + num * buf_size_);
+    float* quant_scale = buf + num * buf_size_ + num * (quant_buf_size_ - 1);
+    layers_[0]->ComputeInt8(input, layer_buf[0], num, quant_buf, quant_scale);
+
+    size_t i; /**< layer index */
+    for (i = 1; i < layers_.size() - 1; i++) {
+      layers_[i]->ComputeInt8(layer_buf[(i + 1) % 2], layer_buf[i % 2], num,
+        quant_buf, quant_scale);
+    }
+    layers_.back()->ComputeInt8(layer_buf[(i + 1) % 2], output, num,
+      quant_buf, quant_scale);
+    return;
+  }
+
+  layers_[0]->Compute(input, layer_buf[0], num);
+
+  size_t i; /**< layer index */
+  for (i = 1; i < layers_.size() - 1; i++)
+    layers_[i]->Compute(layer_buf[(i + 1) % 2], layer_buf[i % 2], num);
+  layers_.back()->Compute(layer_buf[(i + 1) % 2], output, num);
+}
+
+void MLP::SetUseInt8Weights(bool use) {
+  if (use) {
+    for (size_t i = 0; i < layers_.size(); i++)
+      layers_[i]->Quantize();
   }
-  layers_.back()->Compute(layer_buf_[(i + 1) % 2].data(), output);
+  use_int8_ = use;
+}
+
+void MLP::Compute(const float* const* input, const int32_t* part_dim,
+    int32_t num_part, float* output, float* buf,
+    seeta::Executor* executor) const {
+  float* layer_buf[2] = { buf, buf + buf_size_ / 2 };
+  layers_[0]->Compute(input, part_dim, num_part, layer_buf[0]);
+
+  size_t i; /**< layer index */
+  for (i = 1; i < layers_.size() - 1; i++)
+    layers_[i]->Compute(layer_buf[(i + 1) % 2], layer_buf[i % 2], executor);
+  layers_.back()->Compute(layer_buf[(i + 1) % 2], output, executor);
 }
 
 void MLP::AddLayer(int32_t inputDim, int32_t outputDim, const float* weights,
@@ -69,7 +281,15 @@ void MLP::AddLayer(int32_t inputDim, int32_t outputDim, const float* weights,
   layer->SetSize(inputDim, outputDim);
   layer->SetWeights(weights, inputDim * outputDim);
   layer->SetBias(bias, outputDim);
+  if (use_int8_)
+    layer->Quantize();
   layers_.push_back(layer);
+
+  // A quantized input row takes half a float per int16 value plus its scale
+  quant_buf_size_ = std::max(quant_buf_size_,
+    layer->GetPaddedInputDim() / 2 + 1);
+  if (!is_output)
+    buf_size_ = std::max(buf_size_, outputDim * 2);
 }
 
 }  // namespace fd
@@ -31,28 +31,54 @@
 
 #include "classifier/surf_mlp.h"
 
+#include <cstring>
 #include <string>
 
 namespace seeta {
 namespace fd {
 
-bool SURFMLP::Classify(float* score, float* outputs) {
-  float* dest = input_buf_.data();
-  for (size_t i = 0; i < feat_id_.size(); i++) {
-    feat_map_->GetFeatureVector(feat_id_[i] - 1, dest);
-    dest += feat_map_->GetFeatureVectorDim(feat_id_[i]);
+bool SURFMLP::Classify(seeta::fd::FeatureMap* feat_map, float* score,
+    float* outputs) const {
+  seeta::fd::SURFFeatureMap* surf_feat_map =
+    static_cast<seeta::fd::SURFFeatureMap*>(feat_map);
+  int32_t output_dim = model_->GetOutputDim();
+  float* output_buf = surf_feat_map->GetBuffer(output_dim +
+    model_->GetBufferSize());
+  int32_t num_feat = static_cast<int32_t>(feat_id_.size());
+  std::vector<const float*> feat_vec(num_feat);
+  std::vector<int32_t> feat_dim(num_feat);
+
+  // The first layer reads the cached feature vectors in place.
+  for (int32_t i = 0; i < num_feat; i++) {
+    feat_vec[i] = surf_feat_map->GetFeatureVector(feat_id_[i] - 1);
+    feat_dim[i] = surf_feat_map->GetFeatureVectorDim(feat_id_[i] - 1);
   }
-  output_buf_.resize(model_->GetOutputDim());
-  model_->Compute(input_buf_.data(), output_buf_.data());
+  model_->Compute(feat_vec.data(), feat_dim.data(), num_feat, output_buf,
+    output_buf + output_dim, feat_map->executor());
 
   if (score != nullptr)
-    *score = output_buf_[0];
-  if (outputs != nullptr) {
-    std::memcpy(outputs, output_buf_.data(),
-      model_->GetOutputDim() * sizeof(float));
-  }
+    *score = output_buf[0];
+  if (outputs != nullptr)
+    std::memcpy(outputs, output_buf, output_dim * sizeof(float));
+
+  return (output_buf[0] > thresh_);
+}
 
-  return (output_buf_[0] > thresh_);
+void SURFMLP::Classify(const float* input, int32_t num, float* outputs,
+    float* buf) const {
+  model_->Compute(input, outputs, num, buf);
+}
+
+void SURFMLP::GetFeatureVector(seeta::fd::FeatureMap* feat_map,
+    float* feat) const {
+  seeta::fd::SURFFeatureMap* surf_feat_map =
+    static_cast<seeta::fd::SURFFeatureMap*>(feat_map);
+  for (size_t i = 0; i < feat_id_.size(); i++) {
+    int32_t dim = surf_feat_map->GetFeatureVectorDim(feat_id_[i] - 1);
+    std::memcpy(feat, surf_feat_map->GetFeatureVector(feat_id_[i] - 1),
+      dim * sizeof(float));
+    feat += dim;
+  }
 }
 
 void SURFMLP::AddFeatureByID(int32_t feat_id) {
@@ -61,8 +87,6 @@ void SURFMLP::AddFeatureByID(int32_t feat_id) {
 
 void SURFMLP::AddLayer(int32_t input_dim, int32_t output_dim,
     const float* weights, const float* bias, bool is_output) {
-  if (model_->GetLayerNum() == 0)
-    input_buf_.resize(input_dim);
   model_->AddLayer(input_dim, output_dim, weights, bias, is_output);
 }
 
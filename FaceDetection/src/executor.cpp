@@ -0,0 +1,83 @@
+/*
+ *
+ * This file is part of the open-source SeetaFace engine, which includes three modules:
+ * SeetaFace Detection, SeetaFace Alignment, and SeetaFace Identification.
+ *
+ * This file is part of the SeetaFace Detection module, containing codes implementing the
+ * face detection method described in the following paper:
+ *
+ *
+ *   Funnel-structured cascade for multi-view face detection with alignment awareness,
+ *   Shuzhe Wu, Meina Kan, Zhenliang He, Shiguang Shan, Xilin Chen.
+ *   In Neurocomputing (under review)
+ *
+ *
+ * Copyright (C) 2016, Visual Information Processing and Learning (VIPL) group,
+ * Institute of Computing Technology, Chinese Academy of Sciences, Beijing, China.
+ *
+ * The codes are mainly developed by Shuzhe Wu (a Ph.D supervised by Prof. Shiguang Shan)
+ *
+ * As an open-source face recognition engine: you can redistribute SeetaFace source codes
+ * and/or modify it under the terms of the BSD 2-Clause License.
+ *
+ * You should have received a copy of the BSD 2-Clause License along with the software.
+ * If not, see < https://opensource.org/licenses/BSD-2-Clause>.
+ *
+ * Contact Info: you can send an email to SeetaFace@vipl.ict.ac.cn for any problems.
+ *
+ * Note: the above information must be kept whenever or wherever the codes are used.
+ *
+ */
+
+
+
+#include "executor.h"
+
+#include <thread>
+#include <vector>
+
+#include "util/thread_pool.h"
+
+namespace seeta {
+
+class InlineExecutor : public seeta::Executor {
+ public:
+  int32_t num_threads() const { return 1; }
+
+  void ParallelFor(int32_t num_tasks,
+      const std::function<void(int32_t)> & task) {
+    for (int32_t i = 0; i < num_tasks; i++)
+      task(i);
+  }
+};
+
+class ThreadPoolExecutor : public seeta::Executor {
+ public:
+  explicit ThreadPoolExecutor(int32_t num_threads) : pool_(num_threads) {}
+
+  int32_t num_threads() const { return pool_.num_threads(); }
+
+  void ParallelFor(int32_t num_tasks,
+      const std::function<void(int32_t)> & task) {
+    std::vector<seeta::fd::ThreadPool::Task> tasks;
+    for (int32_t i = 0; i < num_tasks; i++)
+      tasks.push_back([&task, i]() { task(i); });
+    pool_.Run(tasks);
+  }
+
+ private:
+  seeta::fd::ThreadPool pool_;
+};
+
+std::shared_ptr<seeta::Executor> CreateInlineExecutor() {
+  return std::shared_ptr<seeta::Executor>(new InlineExecutor());
+}
+
+std::shared_ptr<seeta::Executor> CreateThreadPoolExecutor(
+    int32_t num_threads) {
+  if (num_threads <= 0)
+    num_threads = static_cast<int32_t>(std::thread::hardware_concurrency());
+  return std::shared_ptr<seeta::Executor>(new ThreadPoolExecutor(num_threads));
+}
+
+}  // namespace seeta
@@ -31,23 +31,33 @@
 
 #include "face_detection.h"
 
+#include <algorithm>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 
+#include "detection_context.h"
 #include "detector.h"
 #include "fust.h"
+#include "util/detection_mask.h"
 #include "util/image_pyramid.h"
+#include "util/stats_recorder.h"
+#include "util/time_budget.h"
 
 namespace seeta {
 
 	// @todo Impl   FaceDetection ĸ࣬䶨 FaceDetection жģface_detection.cpp:44 - face_detection.cpp:74
-	class FaceDetection::Impl {
+	class FaceDetection::Impl : public seeta::fd::DetectionContextPool {
 	public:
 		Impl()
 			: detector_(new seeta::fd::FuStDetector()),
-			slide_wnd_step_x_(4), slide_wnd_step_y_(4),
+			slide_wnd_step_x_(4), slide_wnd_step_y_(4), coarse_wnd_step_(0),
 			min_face_size_(20), max_face_size_(-1),
-			cls_thresh_(3.85f) {}
+			img_pyramid_max_scale_(1.0f), img_pyramid_scale_step_(0.8f),
+			cls_thresh_(3.85f), time_budget_us_(0), tile_memory_limit_(0),
+			img_format_(seeta::kImageGray),
+			num_threads_(static_cast<int32_t>(std::thread::hardware_concurrency())) {}
 
 		~Impl() {}
 
@@ -55,8 +65,176 @@ namespace seeta {
 		// жǷǺϷͼƬ
 		// жݣͨΪ1dataǿգͼߡ0
 		inline bool IsLegalImage(const seeta::ImageData & image) {
-			return (image.num_channels == 1 && image.width > 0 && image.height > 0 &&
-				image.data != nullptr);
+			return IsLegalImage(image, GetNumChannels());
+		}
+
+		// Same as above, with `num_channels` channels
+		inline bool IsLegalImage(const seeta::ImageData & image,
+			int32_t num_channels) {
+			return (image.num_channels == num_channels && image.width > 0 &&
+				image.height > 0 && image.data != nullptr &&
+				image.GetStride() >= image.width * num_channels);
+		}
+
+		// Number of channels of images of the current format
+		inline int32_t GetNumChannels() const {
+			return (img_format_ == seeta::kImageBGR ||
+				img_format_ == seeta::kImageRGB ? 3 : 1);
+		}
+
+		// Detect faces on a legal image, searching the windows centered in
+		// `mask` only when it is not nullptr. `is_partial`, if not nullptr,
+		// tells whether the time budget cut the detection short, and `stats`,
+		// if not nullptr, receives the stats of the detection.
+		std::vector<seeta::FaceInfo> Detect(const seeta::ImageData & img,
+			const seeta::fd::DetectionMask* mask, bool* is_partial = nullptr,
+			seeta::DetectionStats* stats = nullptr) {
+			return Detect(img, mask, img_pyramid_max_scale_, max_face_size_,
+				time_budget_us_, is_partial, stats);
+		}
+
+		// Same as above, with the range of face sizes given as for
+		// `SetUpImagePyramid()`, and the time budget in microseconds,
+		// non-positive values meaning no limit
+		std::vector<seeta::FaceInfo> Detect(const seeta::ImageData & img,
+			const seeta::fd::DetectionMask* mask, float max_scale,
+			int32_t max_face_size, int64_t time_budget_us,
+			bool* is_partial = nullptr, seeta::DetectionStats* stats = nullptr) {
+			std::unique_ptr<seeta::fd::TimeBudget> time_budget;
+			if (time_budget_us > 0)
+				time_budget.reset(new seeta::fd::TimeBudget(time_budget_us));
+			std::unique_ptr<seeta::fd::StatsRecorder> stats_recorder;
+			if (stats != nullptr)
+				stats_recorder.reset(new seeta::fd::StatsRecorder(stats));
+
+			std::unique_ptr<seeta::fd::DetectionContext> ctx = AcquireContext();
+			SetUpImagePyramid(img, max_scale, max_face_size, ctx->img_pyramid());
+			ctx->img_pyramid()->SetMask(mask);
+			ctx->img_pyramid()->SetTimeBudget(time_budget.get());
+			ctx->img_pyramid()->SetStatsRecorder(stats_recorder.get());
+
+			// ִʵ
+			std::vector<seeta::FaceInfo> pos_wnds;
+			seeta::Executor* executor = GetExecutor();
+			if (executor->num_threads() <= 1) {
+				ctx->SetExecutor(executor);
+				pos_wnds = detector_->Detect(ctx.get());
+			} else {
+				// Scan the pyramid levels in parallel, as a batch of one image
+				pos_wnds = detector_->Detect(
+					std::vector<seeta::fd::ImagePyramid*>(1, ctx->img_pyramid()),
+					this, executor)[0];
+			}
+			ctx->img_pyramid()->SetMask(nullptr);
+			ctx->img_pyramid()->SetTimeBudget(nullptr);
+			ctx->img_pyramid()->SetStatsRecorder(nullptr);
+			ReleaseContext(std::move(ctx));
+			ApplyScoreThresh(&pos_wnds);
+			bool partial = (time_budget != nullptr && time_budget->is_partial());
+			if (is_partial != nullptr)
+				*is_partial = partial;
+			if (stats != nullptr) {
+				stats->total_us = stats_recorder->GetElapsed();
+				stats->num_faces = static_cast<int32_t>(pos_wnds.size());
+				stats->is_partial = partial;
+			}
+
+			return pos_wnds;
+		}
+
+		// Take an idle detection context, or create a new one when all are busy
+		std::unique_ptr<seeta::fd::DetectionContext> AcquireContext() {
+			std::unique_ptr<seeta::fd::DetectionContext> ctx;
+			{
+				std::lock_guard<std::mutex> lock(ctx_mutex_);
+				if (!idle_ctx_.empty()) {
+					ctx = std::move(idle_ctx_.back());
+					idle_ctx_.pop_back();
+				}
+			}
+			if (ctx == nullptr)
+				ctx = detector_->CreateContext();
+			SetUpContext(ctx.get());
+			return ctx;
+		}
+
+		void ReleaseContext(std::unique_ptr<seeta::fd::DetectionContext> ctx) {
+			std::lock_guard<std::mutex> lock(ctx_mutex_);
+			idle_ctx_.push_back(std::move(ctx));
+		}
+
+		// Set up the pyramid of `img` according to the current scale settings
+		void SetUpImagePyramid(const seeta::ImageData & img,
+			seeta::fd::ImagePyramid* img_pyramid) {
+			SetUpImagePyramid(img, img_pyramid_max_scale_, max_face_size_,
+				img_pyramid);
+		}
+
+		// Set up the pyramid of `img` for faces no smaller than `kWndSize` /
+		// `max_scale` and no larger than `max_face_size` (unlimited if negative)
+		void SetUpImagePyramid(const seeta::ImageData & img, float max_scale,
+			int32_t max_face_size, seeta::fd::ImagePyramid* img_pyramid) {
+			// СͼƬС
+			// ûԶmin_img_sizeͼȡͼ߶ȣѡСǸΪСͼƬС
+			int32_t min_img_size = img.height <= img.width ? img.height : img.width;
+
+			min_img_size = (max_face_size > 0 ?
+				(min_img_size >= max_face_size ? max_face_size : min_img_size) :
+				min_img_size);
+
+			// ͼʼС 
+			img_pyramid->SetScaleStep(img_pyramid_scale_step_);
+			img_pyramid->SetMaxScale(max_scale);
+			img_pyramid->SetImage1x(img, img_format_ == seeta::kImageRGB ?
+				seeta::fd::kChannelRGB : seeta::fd::kChannelBGR);
+
+			// ͼСı
+			// static_cast<type-id> expression 4÷
+			// (1) ڻ֮תintתΪcharintתenumתİȫҪԼ֤Ϊ֤ݵľȣԱܱ֤ܲԼҪĳȫ
+			//     ڰintתΪcharʱcharû㹻ıλintֵint>127int<-127ʱôstatic_castֻǼ򵥵Ľضϣ򵥵ذintĵ8λƵchar8λУֱλ
+			// (2) ѿָתĿ͵Ŀָ
+			// (3) κ͵ıʽתvoid
+			// (4) νṹиָ֮õת
+			// ϵڣ4㣬ʽתתൽࣩתൽࣩstatic_castתʱȫģתʱȫģΪʲôأ
+			// Ϊstatic_castתǴֱģתṩϢеͣתתʽתǰݳԱͺԱ
+			// ˴תָûκιǵķ䣨ָࣩĳԱתΪʲôȫΪstatic_castֻڱʱͼ飬ûʱͼ飬ԭdynamic_cast˵
+			img_pyramid->SetMinScale(static_cast<float>(kWndSize) / min_img_size);
+		}
+
+		void SetUpContext(seeta::fd::DetectionContext* ctx) {
+			// ôڴС
+			ctx->SetWindowSize(kWndSize);
+
+			// ûڲ
+			ctx->SetSlideWindowStep(slide_wnd_step_x_,
+				slide_wnd_step_y_);
+			ctx->SetCoarseWindowStep(coarse_wnd_step_);
+			ctx->SetTileMemoryLimit(tile_memory_limit_);
+
+			// Loops run inline unless the caller hands the context an executor
+			ctx->SetExecutor(nullptr);
+		}
+
+		// Drop the detections scoring below the threshold, `faces` being sorted
+		void ApplyScoreThresh(std::vector<seeta::FaceInfo>* faces) {
+			for (int32_t i = 0; i < faces->size(); i++) {
+				if ((*faces)[i].score < cls_thresh_) {
+					faces->resize(i);
+					break;
+				}
+			}
+		}
+
+		// Executor used by Detect() and DetectBatch(), the one set by the
+		// caller or else a pool of `num_threads_` threads created on first use
+		seeta::Executor* GetExecutor() {
+			std::lock_guard<std::mutex> lock(ctx_mutex_);
+			if (executor_ == nullptr) {
+				executor_ = (num_threads_ > 1 ?
+					seeta::CreateThreadPoolExecutor(num_threads_) :
+					seeta::CreateInlineExecutor());
+			}
+			return executor_.get();
 		}
 
 	public:
@@ -66,9 +244,13 @@ namespace seeta {
 		int32_t max_face_size_;
 		int32_t slide_wnd_step_x_;
 		int32_t slide_wnd_step_y_;
+		int32_t coarse_wnd_step_;
+		float img_pyramid_max_scale_;
+		float img_pyramid_scale_step_;
 		float cls_thresh_;
-
-		std::vector<seeta::FaceInfo> pos_wnds_;
+		int64_t time_budget_us_;
+		int64_t tile_memory_limit_;
+		seeta::ImageFormat img_format_;
 
 		// unique_ptrжԶĶȨͬһʱֻһunique_ptrָֹͨ塢ֻƶʵ֣
 		// unique_ptrָ뱾ڣunique_ptrָ봴ʱʼֱ뿪
@@ -77,7 +259,14 @@ namespace seeta {
 		// std::unique_ptr<seeta::fd::Detector> detector_3 = std::move(detector_);		//  detector_3 Ψһunique_ptr
 		std::unique_ptr<seeta::fd::Detector> detector_;			// ָĶռָ
 
-		seeta::fd::ImagePyramid img_pyramid_;						// ͼ
+		// Detection contexts not currently used by any Detect() call
+		std::mutex ctx_mutex_;
+		std::vector<std::unique_ptr<seeta::fd::DetectionContext> > idle_ctx_;
+
+		// Executor of the parallel loops, nullptr until first used unless set
+		// by the caller
+		int32_t num_threads_;
+		std::shared_ptr<seeta::Executor> executor_;
 	};
 
 	// ؼģļ
@@ -101,53 +290,148 @@ namespace seeta {
 		if (!impl_->IsLegalImage(img))
 			return std::vector<seeta::FaceInfo>();
 
-		// СͼƬС
-		// ûԶmin_img_sizeͼȡͼ߶ȣѡСǸΪСͼƬС
-		int32_t min_img_size = img.height <= img.width ? img.height : img.width;
-
-		min_img_size = (impl_->max_face_size_ > 0 ?
-			(min_img_size >= impl_->max_face_size_ ? impl_->max_face_size_ : min_img_size) :
-			min_img_size);
-
-		// ͼʼС 
-		impl_->img_pyramid_.SetImage1x(img.data, img.width, img.height);
-
-		// ͼСı
-		// static_cast<type-id> expression 4÷
-		// (1) ڻ֮תintתΪcharintתenumתİȫҪԼ֤Ϊ֤ݵľȣԱܱ֤ܲԼҪĳȫ
-		//     ڰintתΪcharʱcharû㹻ıλintֵint>127int<-127ʱôstatic_castֻǼ򵥵Ľضϣ򵥵ذintĵ8λƵchar8λУֱλ
-		// (2) ѿָתĿ͵Ŀָ
-		// (3) κ͵ıʽתvoid
-		// (4) νṹиָ֮õת
-		// ϵڣ4㣬ʽתתൽࣩתൽࣩstatic_castתʱȫģתʱȫģΪʲôأ
-		// Ϊstatic_castתǴֱģתṩϢеͣתתʽתǰݳԱͺԱ
-		// ˴תָûκιǵķ䣨ָࣩĳԱתΪʲôȫΪstatic_castֻڱʱͼ飬ûʱͼ飬ԭdynamic_cast˵
-		impl_->img_pyramid_.SetMinScale(static_cast<float>(impl_->kWndSize) / min_img_size);
-		
-		// ôڴС
-		impl_->detector_->SetWindowSize(impl_->kWndSize);
-
-		// ûڲ
-		impl_->detector_->SetSlideWindowStep(impl_->slide_wnd_step_x_,
-			impl_->slide_wnd_step_y_);
-
-		// ִʵ
-		impl_->pos_wnds_ = impl_->detector_->Detect(&(impl_->img_pyramid_));
-
-		for (int32_t i = 0; i < impl_->pos_wnds_.size(); i++) {
-			if (impl_->pos_wnds_[i].score < impl_->cls_thresh_) {
-				impl_->pos_wnds_.resize(i);
-				break;
+		return impl_->Detect(img, nullptr);
+	}
+
+	std::vector<seeta::FaceInfo> FaceDetection::Detect(
+		const seeta::ImageData & img, bool* is_partial) {
+		if (is_partial != nullptr)
+			*is_partial = false;
+		if (!impl_->IsLegalImage(img))
+			return std::vector<seeta::FaceInfo>();
+
+		return impl_->Detect(img, nullptr, is_partial);
+	}
+
+	std::vector<seeta::FaceInfo> FaceDetection::Detect(
+		const seeta::ImageData & img, seeta::DetectionStats* stats) {
+		if (!impl_->IsLegalImage(img)) {
+			if (stats != nullptr)
+				*stats = seeta::DetectionStats();
+			return std::vector<seeta::FaceInfo>();
+		}
+
+		return impl_->Detect(img, nullptr, nullptr, stats);
+	}
+
+	std::vector<seeta::FaceInfo> FaceDetection::Detect(
+		const seeta::ImageData & img, const std::vector<seeta::Rect> & rois) {
+		if (!impl_->IsLegalImage(img))
+			return std::vector<seeta::FaceInfo>();
+
+		seeta::fd::DetectionMask mask;
+		mask.SetRects(img.width, img.height, rois);
+		return impl_->Detect(img, &mask);
+	}
+
+	std::vector<seeta::FaceInfo> FaceDetection::Detect(
+		const seeta::ImageData & img, const seeta::ImageData & mask,
+		int32_t cell_size) {
+		if (!impl_->IsLegalImage(img) || !impl_->IsLegalImage(mask, 1) ||
+			cell_size <= 0)
+			return std::vector<seeta::FaceInfo>();
+
+		// Each pixel of the mask covers a square cell of the image
+		if (mask.width != (img.width + cell_size - 1) / cell_size ||
+			mask.height != (img.height + cell_size - 1) / cell_size)
+			return std::vector<seeta::FaceInfo>();
+
+		seeta::fd::DetectionMask detection_mask;
+		detection_mask.SetMask(img.width, img.height, mask.data, cell_size);
+		return impl_->Detect(img, &detection_mask);
+	}
+
+	std::vector<seeta::FaceInfo> FaceDetection::DetectLocal(
+		const seeta::ImageData & img, const seeta::Rect & roi,
+		int32_t min_size, int32_t max_size) {
+		if (!impl_->IsLegalImage(img))
+			return std::vector<seeta::FaceInfo>();
+
+		min_size = std::max(min_size, impl_->min_face_size_);
+		if (impl_->max_face_size_ > 0)
+			max_size = std::min(max_size, impl_->max_face_size_);
+		if (max_size < min_size)
+			return std::vector<seeta::FaceInfo>();
+
+		// Windows centered in `roi` lie within half the largest window size
+		// around it, which is the only part of the image scanned
+		int32_t margin = max_size / 2 + 1;
+		int32_t x1 = std::max(roi.x - margin, 0);
+		int32_t y1 = std::max(roi.y - margin, 0);
+		int32_t x2 = std::min(roi.x + roi.width + margin, img.width);
+		int32_t y2 = std::min(roi.y + roi.height + margin, img.height);
+		if (x2 - x1 < impl_->kWndSize || y2 - y1 < impl_->kWndSize)
+			return std::vector<seeta::FaceInfo>();
+
+		seeta::ImageData crop(x2 - x1, y2 - y1, img.num_channels);
+		crop.data = img.data + y1 * img.GetStride() + x1 * img.num_channels;
+		crop.stride = img.GetStride();
+
+		seeta::Rect crop_roi = roi;
+		crop_roi.x -= x1;
+		crop_roi.y -= y1;
+		seeta::fd::DetectionMask mask;
+		mask.SetRects(crop.width, crop.height,
+			std::vector<seeta::Rect>(1, crop_roi));
+
+		std::vector<seeta::FaceInfo> faces = impl_->Detect(crop, &mask,
+			impl_->kWndSize / static_cast<float>(min_size), max_size,
+			impl_->time_budget_us_);
+		for (size_t i = 0; i < faces.size(); i++) {
+			faces[i].bbox.x += x1;
+			faces[i].bbox.y += y1;
+		}
+		return faces;
+	}
+
+	std::vector<std::vector<seeta::FaceInfo> > FaceDetection::DetectBatch(
+		const std::vector<seeta::ImageData> & imgs) {
+		std::vector<std::vector<seeta::FaceInfo> > faces(imgs.size());
+		seeta::Executor* executor = impl_->GetExecutor();
+
+		// The time budget applies to single images only, so the images are
+		// detected in full whatever the number of threads
+		if (executor->num_threads() <= 1) {
+			for (size_t i = 0; i < imgs.size(); i++) {
+				if (impl_->IsLegalImage(imgs[i])) {
+					faces[i] = impl_->Detect(imgs[i], nullptr,
+						impl_->img_pyramid_max_scale_, impl_->max_face_size_, 0);
+				}
 			}
+			return faces;
+		}
+
+		std::vector<std::unique_ptr<seeta::fd::ImagePyramid> > img_pyramid_buf;
+		std::vector<seeta::fd::ImagePyramid*> img_pyramids;
+		std::vector<size_t> img_idx;
+		for (size_t i = 0; i < imgs.size(); i++) {
+			if (!impl_->IsLegalImage(imgs[i]))
+				continue;
+			img_pyramid_buf.push_back(std::unique_ptr<seeta::fd::ImagePyramid>(
+				new seeta::fd::ImagePyramid()));
+			impl_->SetUpImagePyramid(imgs[i], img_pyramid_buf.back().get());
+			img_pyramids.push_back(img_pyramid_buf.back().get());
+			img_idx.push_back(i);
+		}
+
+		std::vector<std::vector<seeta::FaceInfo> > pos_wnds =
+			impl_->detector_->Detect(img_pyramids, impl_, executor);
+		for (size_t i = 0; i < pos_wnds.size(); i++) {
+			impl_->ApplyScoreThresh(&(pos_wnds[i]));
+			faces[img_idx[i]].swap(pos_wnds[i]);
 		}
 
-		return impl_->pos_wnds_;
+		return faces;
+	}
+
+	void FaceDetection::SetImageFormat(seeta::ImageFormat format) {
+		impl_->img_format_ = format;
 	}
 
 	void FaceDetection::SetMinFaceSize(int32_t size) {
 		if (size >= 20) {
 			impl_->min_face_size_ = size;
-			impl_->img_pyramid_.SetMaxScale(impl_->kWndSize / static_cast<float>(size));
+			impl_->img_pyramid_max_scale_ = impl_->kWndSize / static_cast<float>(size);
 		}
 	}
 
@@ -158,7 +442,7 @@ namespace seeta {
 
 	void FaceDetection::SetImagePyramidScaleFactor(float factor) {
 		if (factor >= 0.01f && factor <= 0.99f)
-			impl_->img_pyramid_.SetScaleStep(static_cast<float>(factor));
+			impl_->img_pyramid_scale_step_ = factor;
 	}
 
 	void FaceDetection::SetWindowStep(int32_t step_x, int32_t step_y) {
@@ -168,9 +452,45 @@ namespace seeta {
 			impl_->slide_wnd_step_y_ = step_y;
 	}
 
+	void FaceDetection::SetCoarseWindowStep(int32_t step) {
+		impl_->coarse_wnd_step_ = (step > 0 ? step : 0);
+	}
+
 	void FaceDetection::SetScoreThresh(float thresh) {
 		if (thresh >= 0)
 			impl_->cls_thresh_ = thresh;
 	}
 
+	void FaceDetection::SetNumThreads(int32_t num) {
+		if (num <= 0)
+			num = static_cast<int32_t>(std::thread::hardware_concurrency());
+		impl_->num_threads_ = num;
+		impl_->executor_.reset();
+	}
+
+	void FaceDetection::SetExecutor(
+		const std::shared_ptr<seeta::Executor> & executor) {
+		impl_->executor_ = executor;
+	}
+
+	void FaceDetection::SetTimeBudget(int64_t microseconds) {
+		impl_->time_budget_us_ = (microseconds > 0 ? microseconds : 0);
+	}
+
+	void FaceDetection::SetTileMemoryLimit(int64_t bytes) {
+		impl_->tile_memory_limit_ = (bytes > 0 ? bytes : 0);
+	}
+
+	void FaceDetection::SetUseInt16Weights(bool use) {
+		impl_->detector_->SetUseInt16Weights(use);
+	}
+
+	void FaceDetection::SetUseInt8Weights(bool use) {
+		impl_->detector_->SetUseInt8Weights(use);
+	}
+
+	void FaceDetection::SetUsePyramidSURFFeatures(bool use) {
+		impl_->detector_->SetUsePyramidSURFFeatures(use);
+	}
+
 }  // namespace seeta
@@ -0,0 +1,184 @@
+/*
+ *
+ * This file is part of the open-source SeetaFace engine, which includes three modules:
+ * SeetaFace Detection, SeetaFace Alignment, and SeetaFace Identification.
+ *
+ * This file is part of the SeetaFace Detection module, containing codes implementing the
+ * face detection method described in the following paper:
+ *
+ *
+ *   Funnel-structured cascade for multi-view face detection with alignment awareness,
+ *   Shuzhe Wu, Meina Kan, Zhenliang He, Shiguang Shan, Xilin Chen.
+ *   In Neurocomputing (under review)
+ *
+ *
+ * Copyright (C) 2016, Visual Information Processing and Learning (VIPL) group,
+ * Institute of Computing Technology, Chinese Academy of Sciences, Beijing, China.
+ *
+ * The codes are mainly developed by Shuzhe Wu (a Ph.D supervised by Prof. Shiguang Shan)
+ *
+ * As an open-source face recognition engine: you can redistribute SeetaFace source codes
+ * and/or modify it under the terms of the BSD 2-Clause License.
+ *
+ * You should have received a copy of the BSD 2-Clause License along with the software.
+ * If not, see < https://opensource.org/licenses/BSD-2-Clause>.
+ *
+ * Contact Info: you can send an email to SeetaFace@vipl.ict.ac.cn for any problems.
+ *
+ * Note: the above information must be kept whenever or wherever the codes are used.
+ *
+ */
+
+
+#include "face_tracker.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "util/motion_detector.h"
+
+namespace seeta {
+
+/** Faces overlapping by more than this are taken as the same face */
+static const float kMaxTrackIoU = 0.5f;
+
+/** Full scans search the changed blocks only below this ratio of them */
+static const float kMaxChangedRatio = 0.5f;
+
+static bool CompareByScore(const seeta::FaceInfo & a,
+    const seeta::FaceInfo & b) {
+  return a.score > b.score;
+}
+
+static float ComputeIoU(const seeta::Rect & a, const seeta::Rect & b) {
+  int32_t x1 = std::max(a.x, b.x);
+  int32_t y1 = std::max(a.y, b.y);
+  int32_t x2 = std::min(a.x + a.width, b.x + b.width);
+  int32_t y2 = std::min(a.y + a.height, b.y + b.height);
+  if (x2 <= x1 || y2 <= y1)
+    return 0.0f;
+  float inter = static_cast<float>(x2 - x1) * (y2 - y1);
+  return inter / (static_cast<float>(a.width) * a.height +
+    static_cast<float>(b.width) * b.height - inter);
+}
+
+FaceTracker::FaceTracker(seeta::FaceDetection* detector)
+    : detector_(detector),
+      motion_detector_(nullptr),
+      full_scan_interval_(10),
+      num_frame_since_scan_(0),
+      full_scan_requested_(true),
+      shift_ratio_(0.5f),
+      scale_ratio_(1.5f) {}
+
+FaceTracker::~FaceTracker() {
+  if (motion_detector_ != nullptr)
+    delete motion_detector_;
+}
+
+std::vector<seeta::FaceInfo> FaceTracker::Track(
+    const seeta::ImageData & img) {
+  bool has_motion = (motion_detector_ != nullptr &&
+    motion_detector_->Update(img));
+  bool full_scan = (full_scan_requested_ ||
+    num_frame_since_scan_ >= full_scan_interval_ - 1);
+
+  if (full_scan && (!has_motion || motion_detector_->num_changed() >
+      kMaxChangedRatio * motion_detector_->num_block_x() *
+      motion_detector_->num_block_y())) {
+    faces_ = detector_->Detect(img);
+    full_scan_requested_ = false;
+    num_frame_since_scan_ = 0;
+    return faces_;
+  }
+
+  // Look for each face around its last position and size
+  std::vector<seeta::FaceInfo> faces;
+  for (size_t i = 0; i < faces_.size(); i++) {
+    const seeta::Rect & bbox = faces_[i].bbox;
+    int32_t shift = static_cast<int32_t>(shift_ratio_ * bbox.width + 0.5f);
+    int32_t max_size = static_cast<int32_t>(bbox.width * scale_ratio_ + 0.5f);
+    seeta::Rect roi;
+    roi.x = bbox.x + bbox.width / 2 - shift;
+    roi.y = bbox.y + bbox.height / 2 - shift;
+    roi.width = roi.height = 2 * shift + 1;
+
+    if (has_motion) {
+      seeta::Rect area = roi;
+      area.x -= max_size / 2;
+      area.y -= max_size / 2;
+      area.width += max_size;
+      area.height += max_size;
+      if (!motion_detector_->IsChanged(area)) {
+        faces.push_back(faces_[i]);
+        continue;
+      }
+    }
+
+    std::vector<seeta::FaceInfo> found = detector_->DetectLocal(img, roi,
+      static_cast<int32_t>(bbox.width / scale_ratio_), max_size);
+    if (!found.empty())
+      faces.push_back(found[0]);
+  }
+
+  if (full_scan) {
+    // Look for new faces in the changed blocks
+    if (motion_detector_->num_changed() > 0) {
+      seeta::ImageData mask(motion_detector_->num_block_x(),
+        motion_detector_->num_block_y(), 1);
+      mask.data = const_cast<uint8_t*>(motion_detector_->changed());
+      std::vector<seeta::FaceInfo> found = detector_->Detect(img, mask,
+        motion_detector_->block_size());
+      faces.insert(faces.end(), found.begin(), found.end());
+    }
+    full_scan_requested_ = false;
+    num_frame_since_scan_ = 0;
+  } else {
+    num_frame_since_scan_++;
+  }
+
+  // Faces that moved onto the same one are kept once
+  std::stable_sort(faces.begin(), faces.end(), CompareByScore);
+  faces_.clear();
+  for (size_t i = 0; i < faces.size(); i++) {
+    bool is_dup = false;
+    for (size_t j = 0; j < faces_.size() && !is_dup; j++)
+      is_dup = (ComputeIoU(faces[i].bbox, faces_[j].bbox) > kMaxTrackIoU);
+    if (!is_dup)
+      faces_.push_back(faces[i]);
+  }
+
+  return faces_;
+}
+
+void FaceTracker::SetFullScanInterval(int32_t interval) {
+  if (interval > 0)
+    full_scan_interval_ = interval;
+}
+
+void FaceTracker::SetUseMotionGate(bool use, int32_t thresh) {
+  if (!use) {
+    if (motion_detector_ != nullptr)
+      delete motion_detector_;
+    motion_detector_ = nullptr;
+    return;
+  }
+  if (motion_detector_ == nullptr)
+    motion_detector_ = new seeta::fd::MotionDetector();
+  if (thresh >= 0)
+    motion_detector_->SetThreshold(thresh);
+}
+
+void FaceTracker::SetSearchRange(float shift_ratio, float scale_ratio) {
+  if (shift_ratio >= 0.0f)
+    shift_ratio_ = shift_ratio;
+  if (scale_ratio >= 1.0f)
+    scale_ratio_ = scale_ratio;
+}
+
+void FaceTracker::Reset() {
+  faces_.clear();
+  full_scan_requested_ = true;
+}
+
+}  // namespace seeta
@@ -34,6 +34,8 @@
 #include <cmath>
 
 #include "util/math_func.h"
+#include "util/parallel_for.h"
+#include "util/simd_kernels.h"
 
 namespace seeta {
 namespace fd {
@@ -50,43 +52,43 @@ void LABFeatureMap::Compute(const uint8_t* input, int32_t width,
   ComputeFeatureMap();
 }
 
-float LABFeatureMap::GetStdDev() const {
+float LABFeatureMap::GetStdDev(const seeta::Rect & roi) const {
   double mean;
   double m2;
-  double area = roi_.width * roi_.height;
+  double area = roi.width * roi.height;
 
   int32_t top_left;
   int32_t top_right;
   int32_t bottom_left;
   int32_t bottom_right;
 
-  if (roi_.x != 0) {
-    if (roi_.y != 0) {
-      top_left = (roi_.y - 1) * width_ + roi_.x - 1;
-      top_right = top_left + roi_.width;
-      bottom_left = top_left + roi_.height * width_;
-      bottom_right = bottom_left + roi_.width;
+  if (roi.x != 0) {
+    if (roi.y != 0) {
+      top_left = (roi.y - 1) * width_ + roi.x - 1;
+      top_right = top_left + roi.width;
+      bottom_left = top_left + roi.height * width_;
+      bottom_right = bottom_left + roi.width;
 
       mean = (int_img_[bottom_right] - int_img_[bottom_left] +
         int_img_[top_left] - int_img_[top_right]) / area;
       m2 = (square_int_img_[bottom_right] - square_int_img_[bottom_left] +
         square_int_img_[top_left] - square_int_img_[top_right]) / area;
     } else {
-      bottom_left = (roi_.height - 1) * width_ + roi_.x - 1;
-      bottom_right = bottom_left + roi_.width;
+      bottom_left = (roi.height - 1) * width_ + roi.x - 1;
+      bottom_right = bottom_left + roi.width;
 
       mean = (int_img_[bottom_right] - int_img_[bottom_left]) / area;
       m2 = (square_int_img_[bottom_right] - square_int_img_[bottom_left]) / area;
     }
   } else {
-    if (roi_.y != 0) {
-      top_right = (roi_.y - 1) * width_ + roi_.width - 1;
-      bottom_right = top_right + roi_.height * width_;
+    if (roi.y != 0) {
+      top_right = (roi.y - 1) * width_ + roi.width - 1;
+      bottom_right = top_right + roi.height * width_;
 
       mean = (int_img_[bottom_right] - int_img_[top_right]) / area;
       m2 = (square_int_img_[bottom_right] - square_int_img_[top_right]) / area;
     } else {
-      bottom_right = (roi_.height - 1) * width_ + roi_.width - 1;
+      bottom_right = (roi.height - 1) * width_ + roi.width - 1;
       mean = int_img_[bottom_right] / area;
       m2 = square_int_img_[bottom_right] / area;
     }
@@ -125,22 +127,18 @@ void LABFeatureMap::ComputeRectSum() {
   seeta::fd::MathFunction::VectorSub(int_img + (rect_height_ - 1) * width_ +
     rect_width_, int_img + (rect_height_ - 1) * width_, rect_sum + 1, width);
 
-#pragma omp parallel num_threads(SEETA_NUM_THREADS)
-  {
-#pragma omp for nowait
-    for (int32_t i = 1; i <= height; i++) {
-      const int32_t* top_left = int_img + (i - 1) * width_;
-      const int32_t* top_right = top_left + rect_width_ - 1;
-      const int32_t* bottom_left = top_left + rect_height_ * width_;
-      const int32_t* bottom_right = bottom_left + rect_width_ - 1;
-      int32_t* dest = rect_sum + i * width_;
-
-      *(dest++) = (*bottom_right) - (*top_right);
-      seeta::fd::MathFunction::VectorSub(bottom_right + 1, top_right + 1, dest, width);
-      seeta::fd::MathFunction::VectorSub(dest, bottom_left, dest, width);
-      seeta::fd::MathFunction::VectorAdd(dest, top_left, dest, width);
-    }
-  }
+  seeta::fd::ParallelFor(executor_, 1, height + 1, [&](int32_t i) {
+    const int32_t* top_left = int_img + (i - 1) * width_;
+    const int32_t* top_right = top_left + rect_width_ - 1;
+    const int32_t* bottom_left = top_left + rect_height_ * width_;
+    const int32_t* bottom_right = bottom_left + rect_width_ - 1;
+    int32_t* dest = rect_sum + i * width_;
+
+    *(dest++) = (*bottom_right) - (*top_right);
+    seeta::fd::MathFunction::VectorSub(bottom_right + 1, top_right + 1, dest, width);
+    seeta::fd::MathFunction::VectorSub(dest, bottom_left, dest, width);
+    seeta::fd::MathFunction::VectorAdd(dest, top_left, dest, width);
+  });
 }
 
 void LABFeatureMap::ComputeFeatureMap() {
@@ -148,35 +146,19 @@ void LABFeatureMap::ComputeFeatureMap() {
   int32_t height = height_ - rect_height_ * num_rect_;
   int32_t offset = width_ * rect_height_;
   uint8_t* feat_map = feat_map_.data();
-
-#pragma omp parallel num_threads(SEETA_NUM_THREADS)
-  {
-#pragma omp for nowait
-    for (int32_t r = 0; r <= height; r++) {
-      for (int32_t c = 0; c <= width; c++) {
-        uint8_t* dest = feat_map + r * width_ + c;
-        *dest = 0;
-
-        int32_t white_rect_sum = rect_sum_[(r + rect_height_) * width_ + c + rect_width_];
-        int32_t black_rect_idx = r * width_ + c;
-        *dest |= (white_rect_sum >= rect_sum_[black_rect_idx] ? 0x80 : 0x0);
-        black_rect_idx += rect_width_;
-        *dest |= (white_rect_sum >= rect_sum_[black_rect_idx] ? 0x40 : 0x0);
-        black_rect_idx += rect_width_;
-        *dest |= (white_rect_sum >= rect_sum_[black_rect_idx] ? 0x20 : 0x0);
-        black_rect_idx += offset;
-        *dest |= (white_rect_sum >= rect_sum_[black_rect_idx] ? 0x08 : 0x0);
-        black_rect_idx += offset;
-        *dest |= (white_rect_sum >= rect_sum_[black_rect_idx] ? 0x01 : 0x0);
-        black_rect_idx -= rect_width_;
-        *dest |= (white_rect_sum >= rect_sum_[black_rect_idx] ? 0x02 : 0x0);
-        black_rect_idx -= rect_width_;
-        *dest |= (white_rect_sum >= rect_sum_[black_rect_idx] ? 0x04 : 0x0);
-        black_rect_idx -= offset;
-        *dest |= (white_rect_sum >= rect_sum_[black_rect_idx] ? 0x10 : 0x0);
-      }
-    }
-  }
+  const int32_t black_offset[8] = {
+    0, rect_width_, rect_width_ * 2, offset + rect_width_ * 2,
+    offset * 2 + rect_width_ * 2, offset * 2 + rect_width_, offset * 2, offset
+  };
+  const seeta::fd::SIMDKernels & kernels = seeta::fd::GetSIMDKernels();
+
+  seeta::fd::ParallelFor(executor_, 0, height + 1, [&](int32_t r) {
+    const int32_t* white = rect_sum_.data() + (r + rect_height_) * width_ +
+      rect_width_;
+    const int32_t* black = rect_sum_.data() + r * width_;
+    kernels.lab_code_row(white, black, black_offset,
+      feat_map + r * width_, width + 1);
+  });
 }
 
 }  // namespace fd
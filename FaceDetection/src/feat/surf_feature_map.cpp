@@ -29,9 +29,17 @@
  *
  */
 
-#include <cmath>
 #include "feat/surf_feature_map.h"
 
+#ifdef USE_SSE
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+
+#include "util/parallel_for.h"
+
 namespace seeta {
 namespace fd {
 
@@ -111,22 +119,20 @@ void SURFFeatureMap::Compute(const uint8_t* input, int32_t width,
     return;  // @todo handle the error!
   }
   Reshape(width, height);
+  NextEpoch();
   ComputeGradientImages(input);
   ComputeIntegralImages();
 }
 
-void SURFFeatureMap::GetFeatureVector(int32_t feat_id, float* feat_vec) {
-  if (buf_valid_[feat_id] == 0) {
-    ComputeFeatureVector(feat_pool_[feat_id], feat_vec_buf_[feat_id].data());
-    NormalizeFeatureVectorL2(feat_vec_buf_[feat_id].data(),
-      feat_vec_normed_buf_[feat_id].data(),
-      static_cast<int32_t>(feat_vec_normed_buf_[feat_id].size()));
-    buf_valid_[feat_id] = 1;
-    buf_valid_reset_ = true;
+const float* SURFFeatureMap::GetFeatureVector(int32_t feat_id) {
+  float* feat_vec_normed = feat_vec_normed_.data() + feat_vec_offset_[feat_id];
+  if (feat_vec_epoch_[feat_id] != epoch_) {
+    ComputeFeatureVector(feat_pool_[feat_id], feat_vec_buf_.data());
+    NormalizeFeatureVectorL2(feat_vec_buf_.data(), feat_vec_normed,
+      GetFeatureVectorDim(feat_id));
+    feat_vec_epoch_[feat_id] = epoch_;
   }
-
-  std::memcpy(feat_vec, feat_vec_normed_buf_[feat_id].data(),
-    feat_vec_normed_buf_[feat_id].size() * sizeof(float));
+  return feat_vec_normed;
 }
 
 void SURFFeatureMap::InitFeaturePool() {
@@ -138,14 +144,18 @@ void SURFFeatureMap::InitFeaturePool() {
   feat_pool_.Create();
 
   int32_t feat_pool_size = static_cast<int32_t>(feat_pool_.size());
-  feat_vec_buf_.resize(feat_pool_size);
-  feat_vec_normed_buf_.resize(feat_pool_size);
-  for (size_t i = 0; i < feat_pool_size; i++) {
-    int32_t dim = GetFeatureVectorDim(static_cast<int32_t>(i));
-    feat_vec_buf_[i].resize(dim);
-    feat_vec_normed_buf_[i].resize(dim);
+  int32_t len = 0;
+  int32_t max_dim = 0;
+  feat_vec_offset_.resize(feat_pool_size);
+  for (int32_t i = 0; i < feat_pool_size; i++) {
+    int32_t dim = GetFeatureVectorDim(i);
+    feat_vec_offset_[i] = len;
+    len += dim;
+    max_dim = std::max(max_dim, dim);
   }
-  buf_valid_.resize(feat_pool_size, 0);
+  feat_vec_buf_.resize(max_dim);
+  feat_vec_normed_.resize(len);
+  feat_vec_epoch_.resize(feat_pool_size, 0);
 }
 
 void SURFFeatureMap::Reshape(int32_t width, int32_t height) {
@@ -170,19 +180,15 @@ void SURFFeatureMap::ComputeGradX(const int32_t* input) {
   int32_t* dx = grad_x_.data();
   int32_t len = width_ - 2;
 
-#pragma omp parallel num_threads(SEETA_NUM_THREADS)
-  {
-#pragma omp for nowait
-    for (int32_t r = 0; r < height_; r++) {
-      const int32_t* src = input + r * width_;
-      int32_t* dest = dx + r * width_;
-      *dest = ((*(src + 1)) - (*src)) << 1;
-      seeta::fd::MathFunction::VectorSub(src + 2, src, dest + 1, len);
-      dest += (width_ - 1);
-      src += (width_ - 1);
-      *dest = ((*src) - (*(src - 1))) << 1;
-    }
-  }
+  seeta::fd::ParallelFor(executor_, 0, height_, [&](int32_t r) {
+    const int32_t* src = input + r * width_;
+    int32_t* dest = dx + r * width_;
+    *dest = ((*(src + 1)) - (*src)) << 1;
+    seeta::fd::MathFunction::VectorSub(src + 2, src, dest + 1, len);
+    dest += (width_ - 1);
+    src += (width_ - 1);
+    *dest = ((*src) - (*(src - 1))) << 1;
+  });
 }
 
 void SURFFeatureMap::ComputeGradY(const int32_t* input) {
@@ -191,15 +197,11 @@ void SURFFeatureMap::ComputeGradY(const int32_t* input) {
   seeta::fd::MathFunction::VectorSub(input + width_, input, dy, len);
   seeta::fd::MathFunction::VectorAdd(dy, dy, dy, len);
 
-#pragma omp parallel num_threads(SEETA_NUM_THREADS)
-  {
-#pragma omp for nowait
-    for (int32_t r = 1; r < height_ - 1; r++) {
-      const int32_t* src = input + (r - 1) * width_;
-      int32_t* dest = dy + r * width_;
-      seeta::fd::MathFunction::VectorSub(src + (width_ << 1), src, dest, len);
-    }
-  }
+  seeta::fd::ParallelFor(executor_, 1, height_ - 1, [&](int32_t r) {
+    const int32_t* src = input + (r - 1) * width_;
+    int32_t* dest = dy + r * width_;
+    seeta::fd::MathFunction::VectorSub(src + (width_ << 1), src, dest, len);
+  });
   int32_t offset = (height_ - 1) * width_;
   dy += offset;
   seeta::fd::MathFunction::VectorSub(input + offset, input + offset - width_,
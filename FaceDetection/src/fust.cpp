@@ -31,6 +31,13 @@
 
 #include "fust.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
 #include <map>
 #include <memory>
 #include <string>
@@ -43,10 +50,209 @@
 #include "io/lab_boost_model_reader.h"
 #include "io/surf_mlp_model_reader.h"
 #include "util/nms.h"
+#include "util/stats_recorder.h"
 
 namespace seeta {
 namespace fd {
 
+/** A band of rows of one pyramid level of one image in a batch */
+typedef struct ScaleTask {
+  int32_t img_idx;
+  int32_t level;
+  seeta::Rect wnd_range;  /**< windows of the band, in window indices */
+  int32_t band_idx;  /**< position of the band among those of the image */
+  int64_t num_pixel;
+} ScaleTask;
+
+/** Number of tasks aimed at per worker, for load balancing */
+static const int32_t kNumTaskPerWorker = 4;
+/** Minimum height of a band in pixels, bounding the overlap overhead */
+static const int32_t kMinBandHeight = 128;
+
+static bool CompareScaleTask(const ScaleTask & a, const ScaleTask & b) {
+  return a.num_pixel > b.num_pixel;
+}
+
+/** Coarse levels first, so that a time budget drops the smallest faces */
+static bool CompareScaleTaskLevel(const ScaleTask & a, const ScaleTask & b) {
+  return a.level > b.level;
+}
+
+/** Share of a time budget given to the sliding window */
+static const float kScanBudgetRatio = 0.7f;
+
+/** Number of windows the later stages classify at a time under a budget */
+static const size_t kBudgetChunkSize = 64;
+
+/**
+ * Base classifiers of the first hierarchy run on the coarse windows in
+ * coarse-to-fine mode, and how much their thresholds are lowered
+ */
+static const int32_t kProbeNumBase = 100;
+static const float kProbeMargin = 1.0f;
+
+/**
+ * Scratch memory per pixel of a tile of the sliding window, i.e. the crop of
+ * the level and the LAB feature map with its 32-bit integral images and
+ * rectangle sums
+ */
+static const int64_t kTileBytesPerPixel = 14;
+/** Same for a window group of the later stages, of 11 32-bit SURF channels */
+static const int64_t kGroupBytesPerPixel = 45;
+
+/**
+ * Number of window columns and rows of the tiles `wnd_range` is split into,
+ * so that the pixels under a tile, widened by `margin_x` and `margin_y`, are
+ * no more than `max_pixel`. Tiles span whole rows of the range if that still
+ * leaves them at least `kMinBandHeight` pixels high, and are about square
+ * otherwise. A tile has at least one window whatever the limit.
+ */
+static void GetTileSize(const seeta::Rect & wnd_range, int32_t wnd_size,
+    int32_t step_x, int32_t step_y, int32_t margin_x, int32_t margin_y,
+    int64_t max_pixel, int32_t* tile_width, int32_t* tile_height) {
+  int64_t width = static_cast<int64_t>(wnd_range.width - 1) * step_x +
+    wnd_size + margin_x;
+  if (width * (kMinBandHeight + margin_y) <= max_pixel) {
+    *tile_width = wnd_range.width;
+  } else {
+    int64_t side = static_cast<int64_t>(std::sqrt(static_cast<double>(max_pixel)));
+    *tile_width = static_cast<int32_t>(std::min<int64_t>(std::max<int64_t>(
+      (side - wnd_size - margin_x) / step_x + 1, 1), wnd_range.width));
+    width = static_cast<int64_t>(*tile_width - 1) * step_x + wnd_size + margin_x;
+  }
+  *tile_height = static_cast<int32_t>(std::min<int64_t>(std::max<int64_t>(
+    (max_pixel / width - wnd_size - margin_y) / step_y + 1, 1),
+    wnd_range.height));
+}
+
+/**
+ * Keep the `num_keep` best scoring of the boxes from `begin` on, in their
+ * order, and drop the others.
+ */
+static void KeepBestScoring(std::vector<seeta::FaceInfo>* bboxes,
+    size_t begin, size_t num_keep) {
+  size_t num = bboxes->size() - begin;
+  if (num_keep >= num)
+    return;
+  if (num_keep == 0) {
+    bboxes->resize(begin);
+    return;
+  }
+
+  std::vector<double> scores(num);
+  for (size_t i = 0; i < num; i++)
+    scores[i] = (*bboxes)[begin + i].score;
+  std::nth_element(scores.begin(), scores.begin() + num_keep - 1, scores.end(),
+    std::greater<double>());
+  double thresh = scores[num_keep - 1];
+  size_t num_above = 0;
+  for (size_t i = 0; i < num; i++) {
+    if ((*bboxes)[begin + i].score > thresh)
+      num_above++;
+  }
+
+  size_t num_at_thresh = num_keep - num_above;
+  size_t idx = begin;
+  for (size_t i = begin; i < bboxes->size(); i++) {
+    double score = (*bboxes)[i].score;
+    if (score > thresh || (score == thresh && num_at_thresh-- > 0))
+      (*bboxes)[idx++] = (*bboxes)[i];
+  }
+  bboxes->resize(idx);
+}
+
+/** A later stage window mapped to a pyramid level */
+typedef struct LevelWindow {
+  int32_t row;       /**< row of the window in the feature matrix */
+  seeta::Rect roi;   /**< window on the level */
+} LevelWindow;
+
+/** Windows of one level sharing the same integral images */
+typedef struct WindowGroup {
+  int32_t level;
+  seeta::Rect rect;  /**< bounding box of the windows */
+  std::vector<LevelWindow> wnds;
+} WindowGroup;
+
+/**
+ * Bound on the area of the bounding box of a window group, relative to the
+ * total area of its windows. Integral images of distant windows are computed
+ * separately rather than over the large area between them.
+ */
+static const int32_t kMaxGroupAreaRatio = 2;
+
+/**
+ * Find the level whose scale is closest to that of `bbox` and the window of
+ * size `wnd_size` it maps to. Fails if the window is not inside the level.
+ */
+static bool MapToPyramidLevel(const seeta::fd::ImagePyramid & img_pyramid,
+    const seeta::Rect & bbox, int32_t wnd_size, int32_t* level,
+    seeta::Rect* roi) {
+  int32_t num_scale = img_pyramid.GetNumScales();
+  if (num_scale <= 0 || bbox.width <= 0)
+    return false;
+
+  float wnd_scale = static_cast<float>(wnd_size) / bbox.width;
+  float scale = img_pyramid.max_scale();
+  float level_scale = scale;
+  float min_diff = std::fabs(std::log(scale / wnd_scale));
+  *level = 0;
+  for (int32_t i = 1; i < num_scale; i++) {
+    scale *= img_pyramid.scale_step();
+    float diff = std::fabs(std::log(scale / wnd_scale));
+    if (diff < min_diff) {
+      min_diff = diff;
+      level_scale = scale;
+      *level = i;
+    }
+  }
+
+  int32_t width;
+  int32_t height;
+  img_pyramid.GetScaleSize(*level, &width, &height);
+  roi->x = static_cast<int32_t>(std::floor(bbox.x * level_scale + 0.5f));
+  roi->y = static_cast<int32_t>(std::floor(bbox.y * level_scale + 0.5f));
+  roi->width = roi->height = wnd_size;
+  return (roi->x >= 0 && roi->y >= 0 && roi->x + wnd_size <= width &&
+    roi->y + wnd_size <= height);
+}
+
+/**
+ * Add `wnd` to a group of the same level nearby whose bounding box stays
+ * within `max_area`, or start a new group.
+ */
+static void AddToWindowGroup(int32_t level, const LevelWindow & wnd,
+    int32_t wnd_size, int64_t max_area, std::vector<WindowGroup>* groups) {
+  int64_t wnd_area = static_cast<int64_t>(wnd_size) * wnd_size;
+  for (size_t i = 0; i < groups->size(); i++) {
+    WindowGroup & group = (*groups)[i];
+    if (group.level != level)
+      continue;
+    int32_t x = std::min(group.rect.x, wnd.roi.x);
+    int32_t y = std::min(group.rect.y, wnd.roi.y);
+    int32_t width = std::max(group.rect.x + group.rect.width,
+      wnd.roi.x + wnd.roi.width) - x;
+    int32_t height = std::max(group.rect.y + group.rect.height,
+      wnd.roi.y + wnd.roi.height) - y;
+    int64_t area = static_cast<int64_t>(width) * height;
+    if (area <= max_area && area <= kMaxGroupAreaRatio * wnd_area *
+        static_cast<int64_t>(group.wnds.size() + 1)) {
+      group.rect.x = x;
+      group.rect.y = y;
+      group.rect.width = width;
+      group.rect.height = height;
+      group.wnds.push_back(wnd);
+      return;
+    }
+  }
+
+  WindowGroup group;
+  group.level = level;
+  group.rect = wnd.roi;
+  group.wnds.push_back(wnd);
+  groups->push_back(group);
+}
+
 bool FuStDetector::LoadModel(const std::string & model_path) {
   std::ifstream model_file(model_path, std::ifstream::binary);
   bool is_loaded = true;
@@ -57,12 +263,15 @@ bool FuStDetector::LoadModel(const std::string & model_path) {
     hierarchy_size_.clear();
     num_stage_.clear();
     wnd_src_id_.clear();
+    model_.clear();
+    stages_.clear();
+    feat_map_type_.clear();
 
     int32_t hierarchy_size;
     int32_t num_stage;
     int32_t num_wnd_src;
     int32_t type_id;
-    int32_t feat_map_index = 0;
+    std::map<seeta::fd::ClassifierType, int32_t> cls2feat_idx;
     std::shared_ptr<seeta::fd::ModelReader> reader;
     std::shared_ptr<seeta::fd::Classifier> classifier;
     seeta::fd::ClassifierType classifier_type;
@@ -72,10 +281,12 @@ bool FuStDetector::LoadModel(const std::string & model_path) {
       model_file.read(reinterpret_cast<char*>(&hierarchy_size),
         sizeof(int32_t));
       hierarchy_size_.push_back(hierarchy_size);
+      size_t hierarchy_begin = stages_.size();
 
       for (int32_t j = 0; is_loaded && j < hierarchy_size; j++) {
         model_file.read(reinterpret_cast<char*>(&num_stage), sizeof(int32_t));
         num_stage_.push_back(num_stage);
+        size_t branch_begin = stages_.size();
 
         for (int32_t k = 0; is_loaded && k < num_stage; k++) {
           model_file.read(reinterpret_cast<char*>(&type_id), sizeof(int32_t));
@@ -87,17 +298,28 @@ bool FuStDetector::LoadModel(const std::string & model_path) {
             reader->Read(&model_file, classifier.get());
           if (is_loaded) {
             model_.push_back(classifier);
-            std::shared_ptr<seeta::fd::FeatureMap> feat_map;
-            if (cls2feat_idx_.count(classifier_type) == 0) {
-              feat_map_.push_back(CreateFeatureMap(classifier_type));
-              cls2feat_idx_.insert(
+            if (cls2feat_idx.count(classifier_type) == 0) {
+              cls2feat_idx.insert(
                 std::map<seeta::fd::ClassifierType, int32_t>::value_type(
-                classifier_type, feat_map_index++));
+                classifier_type, static_cast<int32_t>(feat_map_type_.size())));
+              feat_map_type_.push_back(classifier_type);
+            }
+            CascadeStage stage;
+            stage.lab = nullptr;
+            stage.surf_mlp = nullptr;
+            if (classifier_type == seeta::fd::ClassifierType::SURF_MLP) {
+              stage.surf_mlp =
+                static_cast<const seeta::fd::SURFMLP*>(classifier.get());
+            } else {
+              stage.lab = static_cast<const seeta::fd::LABBoostedClassifier*>(
+                classifier.get());
             }
-            feat_map = feat_map_[cls2feat_idx_.at(classifier_type)];
-            model_.back()->SetFeatureMap(feat_map.get());
+            stage.feat_map_idx = cls2feat_idx.at(classifier_type);
+            stages_.push_back(stage);
           }
         }
+        for (size_t k = branch_begin; k < stages_.size(); k++)
+          stages_[k].branch_end = static_cast<int32_t>(stages_.size());
 
         wnd_src_id_.push_back(std::vector<int32_t>());
         model_file.read(reinterpret_cast<char*>(&num_wnd_src), sizeof(int32_t));
@@ -109,6 +331,8 @@ bool FuStDetector::LoadModel(const std::string & model_path) {
           }
         }
       }
+      for (size_t j = hierarchy_begin; j < stages_.size(); j++)
+        stages_[j].hierarchy_end = static_cast<int32_t>(stages_.size());
     }
 
     model_file.close();
@@ -117,119 +341,601 @@ bool FuStDetector::LoadModel(const std::string & model_path) {
   return is_loaded;
 }
 
+std::unique_ptr<seeta::fd::DetectionContext>
+FuStDetector::CreateContext() const {
+  std::unique_ptr<seeta::fd::DetectionContext> ctx(
+    new seeta::fd::DetectionContext());
+  for (size_t i = 0; i < feat_map_type_.size(); i++)
+    ctx->AddFeatureMap(CreateFeatureMap(feat_map_type_[i]));
+  ctx->wnd_cost()->assign(model_.size(), 0.0f);
+  ctx->wnd_count()->assign(model_.size(), 0.0f);
+  return ctx;
+}
+
 // ʵⷽ
 std::vector<seeta::FaceInfo> FuStDetector::Detect(
-    seeta::fd::ImagePyramid* img_pyramid) {
+    seeta::fd::DetectionContext* ctx) const {
+  // In tiled mode, levels are resized tile by tile instead
+  seeta::fd::ImagePyramid* img_pyramid = ctx->img_pyramid();
+  if (ctx->tile_memory_limit() <= 0)
+    img_pyramid->BuildScaleImages();
+
+  // Sliding window
+
+  std::vector<std::vector<seeta::FaceInfo> > proposals(hierarchy_size_[0]);
+
+  int32_t num_scale = img_pyramid->GetNumScales();
+  seeta::fd::TimeBudget* time_budget = img_pyramid->time_budget();
+  if (time_budget == nullptr) {
+    for (int32_t i = 0; i < num_scale; i++) {
+      SlideWindow(img_pyramid, i, GetWindowRange(img_pyramid, i, ctx), ctx,
+        &proposals);
+    }
+    return RunFollowingClassifiers(&proposals, img_pyramid, ctx);
+  }
+
+  // Scan from the coarsest level, and stop before a level whose cost, taken
+  // as proportional to its size, would exceed the share of the sliding window
+  int64_t scan_budget = static_cast<int64_t>(
+    time_budget->budget() * kScanBudgetRatio);
+  int64_t scan_start = time_budget->GetElapsed();
+  int64_t num_pixel = 0;
+  for (int32_t i = num_scale - 1; i >= 0; i--) {
+    int32_t width;
+    int32_t height;
+    img_pyramid->GetScaleSize(i, &width, &height);
+    int64_t level_pixel = static_cast<int64_t>(width) * height;
+    int64_t elapsed = time_budget->GetElapsed();
+    if (elapsed >= scan_budget || (num_pixel > 0 && elapsed +
+        (elapsed - scan_start) * level_pixel / num_pixel > scan_budget)) {
+      time_budget->SetPartial();
+      break;
+    }
+    SlideWindow(img_pyramid, i, GetWindowRange(img_pyramid, i, ctx), ctx,
+      &proposals);
+    num_pixel += level_pixel;
+  }
+
+  return RunFollowingClassifiers(&proposals, img_pyramid, ctx);
+}
+
+std::vector<std::vector<seeta::FaceInfo> > FuStDetector::Detect(
+    const std::vector<seeta::fd::ImagePyramid*> & img_pyramids,
+    seeta::fd::DetectionContextPool* ctx_pool,
+    seeta::Executor* executor) const {
+  std::unique_ptr<seeta::fd::DetectionContext> setup_ctx =
+    ctx_pool->AcquireContext();
+  int32_t num_img = static_cast<int32_t>(img_pyramids.size());
+  int32_t wnd_size = setup_ctx->wnd_size();
+  int32_t slide_wnd_step_x = setup_ctx->slide_wnd_step_x();
+  int32_t slide_wnd_step_y = setup_ctx->slide_wnd_step_y();
+  bool is_tiled = (setup_ctx->tile_memory_limit() > 0);
+  std::vector<std::vector<seeta::FaceInfo> > faces(num_img);
+  std::vector<std::vector<std::vector<std::vector<seeta::FaceInfo> > > >
+    band_proposals(num_img);
+  std::unique_ptr<std::atomic<int32_t>[]> num_band_left(
+    new std::atomic<int32_t>[num_img]);
+  std::vector<ScaleTask> scale_tasks;
+
+  // Windows to scan at each level, and the number of pixels under them
+  std::vector<std::vector<seeta::Rect> > wnd_range(num_img);
+  int64_t total_pixel = 0;
+  for (int32_t i = 0; i < num_img; i++) {
+    int32_t num_scale = img_pyramids[i]->GetNumScales();
+    for (int32_t j = 0; j < num_scale; j++) {
+      wnd_range[i].push_back(GetWindowRange(img_pyramids[i], j,
+        setup_ctx.get()));
+      const seeta::Rect & range = wnd_range[i].back();
+      if (range.width > 0 && range.height > 0) {
+        total_pixel += static_cast<int64_t>(
+          (range.width - 1) * slide_wnd_step_x + wnd_size) *
+          ((range.height - 1) * slide_wnd_step_y + wnd_size);
+      }
+    }
+  }
+  ctx_pool->ReleaseContext(std::move(setup_ctx));
+  int64_t band_pixel = total_pixel /
+    (std::max(executor->num_threads(), 1) * kNumTaskPerWorker);
+
+  // Split the windows of each level into bands of window rows. A band reads
+  // the image rows under its windows only, so bands of a level are
+  // independent, and LAB features and the std dev of a window depend on the
+  // pixels inside it only and come out the same as when scanning the whole
+  // level.
+  for (int32_t i = 0; i < num_img; i++) {
+    int32_t num_scale = img_pyramids[i]->GetNumScales();
+    int32_t band_idx = 0;
+    for (int32_t j = 0; j < num_scale; j++) {
+      const seeta::Rect & range = wnd_range[i][j];
+      if (range.width <= 0 || range.height <= 0)
+        continue;
+
+      int32_t width = (range.width - 1) * slide_wnd_step_x + wnd_size;
+      int64_t num_pixel = static_cast<int64_t>(width) *
+        ((range.height - 1) * slide_wnd_step_y + wnd_size);
+      int32_t num_band = (band_pixel > 0 ?
+        static_cast<int32_t>(num_pixel / band_pixel) : 1);
+      num_band = std::max(num_band, 1);
+      int32_t band_height = std::max((range.height + num_band - 1) / num_band,
+        kMinBandHeight / slide_wnd_step_y);
+
+      for (int32_t k = 0; k < range.height; k += band_height) {
+        ScaleTask task;
+        task.img_idx = i;
+        task.level = j;
+        task.wnd_range = range;
+        task.wnd_range.y += k;
+        task.wnd_range.height = std::min(band_height, range.height - k);
+        task.band_idx = band_idx++;
+        task.num_pixel = static_cast<int64_t>(width) *
+          ((task.wnd_range.height - 1) * slide_wnd_step_y + wnd_size);
+        scale_tasks.push_back(task);
+      }
+    }
+    band_proposals[i].resize(band_idx,
+      std::vector<std::vector<seeta::FaceInfo> >(hierarchy_size_[0]));
+    num_band_left[i] = band_idx;
+  }
+  bool has_time_budget = false;
+  for (int32_t i = 0; i < num_img; i++) {
+    if (img_pyramids[i]->time_budget() != nullptr)
+      has_time_budget = true;
+  }
+  std::stable_sort(scale_tasks.begin(), scale_tasks.end(), has_time_budget ?
+    seeta::fd::CompareScaleTaskLevel : seeta::fd::CompareScaleTask);
+
+  // Levels are resized from one another, so each pyramid is built as a whole
+  // before its bands are scanned, unless the bands resize their tiles.
+  if (!is_tiled) {
+    executor->ParallelFor(num_img, [&](int32_t i) {
+      img_pyramids[i]->BuildScaleImages();
+    });
+  }
+
+  // Whichever task finishes the last band of an image merges its proposals
+  // in band order, which keeps the result identical to the sequential path,
+  // and runs the later stages.
+  executor->ParallelFor(static_cast<int32_t>(scale_tasks.size()),
+    [&](int32_t i) {
+      const ScaleTask & scale_task = scale_tasks[i];
+      int32_t img_idx = scale_task.img_idx;
+      std::unique_ptr<seeta::fd::DetectionContext> ctx =
+        ctx_pool->AcquireContext();
+      const seeta::fd::ImagePyramid* img_pyramid = img_pyramids[img_idx];
+      seeta::fd::TimeBudget* time_budget = img_pyramid->time_budget();
+      if (time_budget != nullptr && time_budget->GetElapsed() >=
+          time_budget->budget() * kScanBudgetRatio) {
+        time_budget->SetPartial();
+      } else {
+        SlideWindow(img_pyramid, scale_task.level, scale_task.wnd_range,
+          ctx.get(), &(band_proposals[img_idx][scale_task.band_idx]));
+      }
+
+      if (--num_band_left[img_idx] == 0) {
+        std::vector<std::vector<seeta::FaceInfo> > proposals(hierarchy_size_[0]);
+        for (size_t j = 0; j < band_proposals[img_idx].size(); j++) {
+          for (int32_t k = 0; k < hierarchy_size_[0]; k++) {
+            proposals[k].insert(proposals[k].end(),
+              band_proposals[img_idx][j][k].begin(),
+              band_proposals[img_idx][j][k].end());
+          }
+        }
+        band_proposals[img_idx].clear();
+        faces[img_idx] = RunFollowingClassifiers(&proposals, img_pyramid,
+          ctx.get());
+      }
+      ctx_pool->ReleaseContext(std::move(ctx));
+    });
+
+  return faces;
+}
+
+/** Position on the 1x image of the center of a window at `pos` on a level */
+static inline int32_t GetWindowCenter(int32_t pos, int32_t wnd_size,
+    float scale_factor) {
+  return static_cast<int32_t>((pos + wnd_size / 2) / scale_factor);
+}
+
+/**
+ * Narrow the `*num` windows starting at `*first` in one direction to those
+ * whose centers lie in [begin, begin + len) on the 1x image.
+ */
+static void ClipWindowRange(int32_t begin, int32_t len, int32_t step,
+    int32_t wnd_size, float scale_factor, int32_t* first, int32_t* num) {
+  int32_t k1 = *first;
+  int32_t k2 = *first + *num;
+  while (k1 < k2 &&
+      GetWindowCenter(k1 * step, wnd_size, scale_factor) < begin)
+    k1++;
+  while (k2 > k1 &&
+      GetWindowCenter((k2 - 1) * step, wnd_size, scale_factor) >= begin + len)
+    k2--;
+  *first = k1;
+  *num = k2 - k1;
+}
+
+seeta::Rect FuStDetector::GetWindowRange(
+    const seeta::fd::ImagePyramid* img_pyramid, int32_t level,
+    const seeta::fd::DetectionContext* ctx) const {
+  int32_t wnd_size = ctx->wnd_size();
+  int32_t slide_wnd_step_x = ctx->slide_wnd_step_x();
+  int32_t slide_wnd_step_y = ctx->slide_wnd_step_y();
+  int32_t width;
+  int32_t height;
+  img_pyramid->GetScaleSize(level, &width, &height);
+
+  seeta::Rect range;
+  range.x = range.y = 0;
+  range.width = (width >= wnd_size ? (width - wnd_size) / slide_wnd_step_x + 1 : 0);
+  range.height = (height >= wnd_size ? (height - wnd_size) / slide_wnd_step_y + 1 : 0);
+
+  const seeta::fd::DetectionMask* mask = img_pyramid->mask();
+  if (mask != nullptr) {
+    const seeta::Rect & bbox = mask->bbox();
+    float scale_factor = img_pyramid->GetScale(level);
+    ClipWindowRange(bbox.x, bbox.width, slide_wnd_step_x, wnd_size,
+      scale_factor, &range.x, &range.width);
+    ClipWindowRange(bbox.y, bbox.height, slide_wnd_step_y, wnd_size,
+      scale_factor, &range.y, &range.height);
+  }
+  return range;
+}
+
+void FuStDetector::SlideWindow(const seeta::fd::ImagePyramid* img_pyramid,
+    int32_t level, const seeta::Rect & wnd_range,
+    seeta::fd::DetectionContext* ctx,
+    std::vector<std::vector<seeta::FaceInfo> >* proposals) const {
+  if (wnd_range.width <= 0 || wnd_range.height <= 0)
+    return;
+  int64_t max_pixel = ctx->tile_memory_limit() / kTileBytesPerPixel;
+  if (max_pixel <= 0) {
+    ScanWindows(img_pyramid, level, wnd_range, ctx, proposals);
+    return;
+  }
+
+  // Tiles split the windows of the range, so each window is scanned once,
+  // and overlap by the pixels that windows of adjacent tiles share, as well
+  // as by the coarse windows probed around them in coarse-to-fine mode.
+  // Windows depend on the pixels inside them only and score the same as on
+  // the whole level. Their proposals go into the same lists as those of the
+  // other tiles and levels.
+  int32_t slide_wnd_step_x = ctx->slide_wnd_step_x();
+  int32_t slide_wnd_step_y = ctx->slide_wnd_step_y();
+  int32_t margin_x = 2 * slide_wnd_step_x *
+    (std::max(ctx->coarse_wnd_step() / slide_wnd_step_x, 1) - 1);
+  int32_t margin_y = 2 * slide_wnd_step_y *
+    (std::max(ctx->coarse_wnd_step() / slide_wnd_step_y, 1) - 1);
+  int32_t tile_width;
+  int32_t tile_height;
+  GetTileSize(wnd_range, ctx->wnd_size(), slide_wnd_step_x, slide_wnd_step_y,
+    margin_x, margin_y, max_pixel, &tile_width, &tile_height);
+
+  seeta::Rect tile;
+  for (int32_t y = 0; y < wnd_range.height; y += tile_height) {
+    tile.y = wnd_range.y + y;
+    tile.height = std::min(tile_height, wnd_range.height - y);
+    for (int32_t x = 0; x < wnd_range.width; x += tile_width) {
+      tile.x = wnd_range.x + x;
+      tile.width = std::min(tile_width, wnd_range.width - x);
+      ScanWindows(img_pyramid, level, tile, ctx, proposals);
+    }
+  }
+}
+
+void FuStDetector::ScanWindows(const seeta::fd::ImagePyramid* img_pyramid,
+    int32_t level, const seeta::Rect & wnd_range,
+    seeta::fd::DetectionContext* ctx,
+    std::vector<std::vector<seeta::FaceInfo> >* proposals) const {
   float score;
   seeta::FaceInfo wnd_info;
   seeta::Rect wnd;
-  float scale_factor = 0.0;
-  const seeta::ImageData* img_scaled =
-    img_pyramid->GetNextScaleImage(&scale_factor);
+  int32_t wnd_size = ctx->wnd_size();
+  int32_t slide_wnd_step_x = ctx->slide_wnd_step_x();
+  int32_t slide_wnd_step_y = ctx->slide_wnd_step_y();
+  float scale_factor = img_pyramid->GetScale(level);
+  const seeta::fd::DetectionMask* mask = img_pyramid->mask();
+  seeta::fd::FeatureMap* feat_map_1 = ctx->feat_map(stages_[0].feat_map_idx);
 
-  wnd.height = wnd.width = wnd_size_;
+  seeta::fd::StatsRecorder* stats_recorder = img_pyramid->stats_recorder();
+  seeta::DetectionStats::Level level_stats;
+  std::vector<int64_t> stage_us;
+  int64_t start = 0;
+  if (stats_recorder != nullptr) {
+    level_stats.scale = scale_factor;
+    level_stats.num_pass.assign(hierarchy_size_[0], 0);
+    stage_us.assign(hierarchy_size_[0], 0);
+    start = stats_recorder->GetElapsed();
+  }
 
-  // Sliding window
+  // Feature maps cover the pixels under the windows of the range only, and
+  // under the coarse windows around it in coarse-to-fine mode. Rows of a
+  // built level are used in place, and narrower areas copied, or resized
+  // from the 1x image when the level is not built.
+  int32_t level_width;
+  int32_t level_height;
+  img_pyramid->GetScaleSize(level, &level_width, &level_height);
+  level_stats.width = level_width;
+  level_stats.height = level_height;
+  seeta::Rect map_range = wnd_range;
+  seeta::Rect probe_range;
+  int32_t ratio_x;
+  int32_t ratio_y;
+  bool coarse_to_fine = GetProbeRange(level_width, level_height,
+    wnd_range, ctx, &ratio_x, &ratio_y, &probe_range);
+  if (coarse_to_fine) {
+    map_range.x = std::min(wnd_range.x, probe_range.x);
+    map_range.y = std::min(wnd_range.y, probe_range.y);
+    map_range.width = std::max(wnd_range.x + wnd_range.width,
+      probe_range.x + probe_range.width) - map_range.x;
+    map_range.height = std::max(wnd_range.y + wnd_range.height,
+      probe_range.y + probe_range.height) - map_range.y;
+  }
+  int32_t offset_x = map_range.x * slide_wnd_step_x;
+  int32_t offset_y = map_range.y * slide_wnd_step_y;
+  int32_t max_x = (map_range.width - 1) * slide_wnd_step_x;
+  int32_t max_y = (map_range.height - 1) * slide_wnd_step_y;
+  seeta::ImageData img_scaled(level_width, max_y + wnd_size, 1);
+  if (img_pyramid->is_built() && offset_x == 0 &&
+      max_x + wnd_size > level_width - slide_wnd_step_x) {
+    img_scaled.data = img_pyramid->GetScaleImage(level).data +
+      offset_y * level_width;
+  } else {
+    std::vector<uint8_t> & img_crop = *(ctx->img_crop_buf());
+    seeta::Rect crop_rect;
+    crop_rect.x = offset_x;
+    crop_rect.y = offset_y;
+    crop_rect.width = img_scaled.width = max_x + wnd_size;
+    crop_rect.height = img_scaled.height;
+    img_crop.resize(img_scaled.width * img_scaled.height);
+    img_scaled.data = img_crop.data();
+    img_pyramid->GetScaleRegion(level, crop_rect, ctx->resizer(), &img_scaled);
+    if (stats_recorder != nullptr && !img_pyramid->is_built()) {
+      int64_t now = stats_recorder->GetElapsed();
+      level_stats.resize_us = now - start;
+      start = now;
+    }
+  }
 
-  std::vector<std::vector<seeta::FaceInfo> > proposals(hierarchy_size_[0]);
-  std::shared_ptr<seeta::fd::FeatureMap> & feat_map_1 =
-    feat_map_[cls2feat_idx_[model_[0]->type()]];
+  wnd.height = wnd.width = wnd_size;
+  feat_map_1->Compute(img_scaled.data, img_scaled.width, img_scaled.height);
+  if (stats_recorder != nullptr) {
+    int64_t now = stats_recorder->GetElapsed();
+    level_stats.feat_map_us = now - start;
+    start = now;
+  }
+
+  wnd_info.bbox.width = static_cast<int32_t>(wnd_size / scale_factor + 0.5);
+  wnd_info.bbox.height = wnd_info.bbox.width;
 
-  while (img_scaled != nullptr) {
-    feat_map_1->Compute(img_scaled->data, img_scaled->width,
-      img_scaled->height);
+  std::vector<uint8_t> & wnd_flag = *(ctx->wnd_flag_buf());
+  if (coarse_to_fine) {
+    wnd_flag.assign(wnd_range.width * wnd_range.height, 0);
+    level_stats.num_probe = ProbeWindows(
+      static_cast<const seeta::fd::LABFeatureMap*>(feat_map_1), map_range,
+      probe_range, ratio_x, ratio_y, wnd_range, ctx, wnd_flag.data());
+  }
+
+  std::vector<int32_t> wnd_x(wnd_range.width);
+  std::vector<int32_t> wnd_offset(wnd_range.width);
+  std::vector<int32_t> wnd_idx(wnd_range.width);
+  std::vector<float> wnd_score(wnd_range.width);
 
-    wnd_info.bbox.width = static_cast<int32_t>(wnd_size_ / scale_factor + 0.5);
-    wnd_info.bbox.height = wnd_info.bbox.width;
+  int32_t begin_x = (wnd_range.x - map_range.x) * slide_wnd_step_x;
+  int32_t begin_y = (wnd_range.y - map_range.y) * slide_wnd_step_y;
+  for (int32_t r = 0; r < wnd_range.height; r++) {
+    int32_t y = begin_y + r * slide_wnd_step_y;
+    wnd.y = y;
+    wnd_info.bbox.y = static_cast<int32_t>((y + offset_y) / scale_factor + 0.5);
 
-    int32_t max_x = img_scaled->width - wnd_size_;
-    int32_t max_y = img_scaled->height - wnd_size_;
-    for (int32_t y = 0; y <= max_y; y += slide_wnd_step_y_) {
-      wnd.y = y;
-      for (int32_t x = 0; x <= max_x; x += slide_wnd_step_x_) {
-        wnd.x = x;
-        feat_map_1->SetROI(wnd);
+    // Windows of the row centered in the allowed region
+    const uint8_t* row_flag = (coarse_to_fine ?
+      wnd_flag.data() + r * wnd_range.width : nullptr);
+    int32_t num_wnd_x = 0;
+    int32_t center_y = GetWindowCenter(y + offset_y, wnd_size, scale_factor);
+    for (int32_t c = 0; c < wnd_range.width; c++) {
+      int32_t x = begin_x + c * slide_wnd_step_x;
+      if (row_flag != nullptr && row_flag[c] == 0)
+        continue;
+      if (mask != nullptr && !mask->Contains(
+          GetWindowCenter(x + offset_x, wnd_size, scale_factor), center_y))
+        continue;
+      wnd_x[num_wnd_x++] = x;
+    }
+    if (num_wnd_x == 0)
+      continue;
+    level_stats.num_wnd += num_wnd_x;
 
-        wnd_info.bbox.x = static_cast<int32_t>(x / scale_factor + 0.5);
-        wnd_info.bbox.y = static_cast<int32_t>(y / scale_factor + 0.5);
+    // LAB boosted classifiers take a whole row of windows at once
+    for (int32_t k = 0; k < num_wnd_x; k++)
+      wnd_offset[k] = y * img_scaled.width + wnd_x[k];
 
-        for (int32_t i = 0; i < hierarchy_size_[0]; i++) {
-          if (model_[i]->Classify(&score)) {
+    for (int32_t i = 0; i < hierarchy_size_[0]; i++) {
+      size_t num_proposal = (*proposals)[i].size();
+      int64_t stage_start = (stats_recorder != nullptr ?
+        stats_recorder->GetElapsed() : 0);
+      if (stages_[i].lab != nullptr) {
+        int32_t num_pos = stages_[i].lab->Classify(
+          static_cast<const seeta::fd::LABFeatureMap*>(feat_map_1),
+          wnd_offset.data(), num_wnd_x, wnd_size, wnd_idx.data(),
+          wnd_score.data());
+
+        for (int32_t k = 0; k < num_pos; k++) {
+          int32_t x = wnd_x[wnd_idx[k]] + offset_x;
+          wnd_info.bbox.x = static_cast<int32_t>(x / scale_factor + 0.5);
+          wnd_info.score = static_cast<double>(wnd_score[k]);
+          (*proposals)[i].push_back(wnd_info);
+        }
+      } else {
+        for (int32_t k = 0; k < num_wnd_x; k++) {
+          wnd.x = wnd_x[k];
+          feat_map_1->SetROI(wnd);
+          if (stages_[i].surf_mlp->Classify(feat_map_1, &score)) {
+            wnd_info.bbox.x = static_cast<int32_t>(
+              (wnd.x + offset_x) / scale_factor + 0.5);
             wnd_info.score = static_cast<double>(score);
-            proposals[i].push_back(wnd_info);
+            (*proposals)[i].push_back(wnd_info);
           }
         }
       }
+      if (stats_recorder != nullptr) {
+        stage_us[i] += stats_recorder->GetElapsed() - stage_start;
+        level_stats.num_pass[i] += (*proposals)[i].size() - num_proposal;
+      }
     }
+  }
 
-    img_scaled = img_pyramid->GetNextScaleImage(&scale_factor);
+  if (stats_recorder != nullptr) {
+    level_stats.scan_us = stats_recorder->GetElapsed() - start;
+    stats_recorder->AddLevel(level, level_stats);
+    for (int32_t i = 0; i < hierarchy_size_[0]; i++)
+      stats_recorder->AddStageTime(0, i, stage_us[i]);
+    stats_recorder->AddProposals(0, level_stats.num_wnd, 0);
   }
+}
+
+/**
+ * First and number of the windows spanned by those at every `ratio`-th index
+ * among the `num` of a level that are less than `ratio` windows away from one
+ * of the `len` starting at `begin`
+ */
+static void GetCoarseSpan(int32_t begin, int32_t len, int32_t num,
+    int32_t ratio, int32_t* first, int32_t* span) {
+  int32_t lo = std::max(begin - ratio + 1, 0);
+  int32_t hi = std::min(begin + len + ratio - 1, num);
+  *first = (lo + ratio - 1) / ratio * ratio;
+  *span = (hi - 1 - *first) / ratio * ratio + 1;
+}
+
+bool FuStDetector::GetProbeRange(int32_t width, int32_t height,
+    const seeta::Rect & wnd_range, const seeta::fd::DetectionContext* ctx,
+    int32_t* ratio_x, int32_t* ratio_y, seeta::Rect* probe_range) const {
+  int32_t wnd_size = ctx->wnd_size();
+  int32_t slide_wnd_step_x = ctx->slide_wnd_step_x();
+  int32_t slide_wnd_step_y = ctx->slide_wnd_step_y();
+  *ratio_x = std::max(ctx->coarse_wnd_step() / slide_wnd_step_x, 1);
+  *ratio_y = std::max(ctx->coarse_wnd_step() / slide_wnd_step_y, 1);
+  if (*ratio_x == 1 && *ratio_y == 1)
+    return false;
+  for (int32_t i = 0; i < hierarchy_size_[0]; i++) {
+    if (stages_[i].lab == nullptr)
+      return false;
+  }
+
+  GetCoarseSpan(wnd_range.x, wnd_range.width,
+    (width - wnd_size) / slide_wnd_step_x + 1, *ratio_x, &probe_range->x,
+    &probe_range->width);
+  GetCoarseSpan(wnd_range.y, wnd_range.height,
+    (height - wnd_size) / slide_wnd_step_y + 1, *ratio_y, &probe_range->y,
+    &probe_range->height);
+  return true;
+}
+
+int32_t FuStDetector::ProbeWindows(const seeta::fd::LABFeatureMap* feat_map,
+    const seeta::Rect & map_range, const seeta::Rect & probe_range,
+    int32_t ratio_x, int32_t ratio_y, const seeta::Rect & wnd_range,
+    const seeta::fd::DetectionContext* ctx, uint8_t* wnd_flag) const {
+  int32_t slide_wnd_step_x = ctx->slide_wnd_step_x();
+  int32_t slide_wnd_step_y = ctx->slide_wnd_step_y();
+  int32_t num_x = (probe_range.width - 1) / ratio_x + 1;
+  std::vector<int32_t> wnd_offset(num_x);
+  std::vector<int32_t> wnd_idx(num_x);
+  std::vector<float> wnd_score(num_x);
+  std::vector<uint8_t> is_hit(num_x);
+  int32_t num_probe = 0;
+
+  for (int32_t y = probe_range.y; y < probe_range.y + probe_range.height;
+      y += ratio_y) {
+    for (int32_t k = 0; k < num_x; k++) {
+      wnd_offset[k] = (y - map_range.y) * slide_wnd_step_y * feat_map->width() +
+        (probe_range.x + k * ratio_x - map_range.x) * slide_wnd_step_x;
+    }
+    std::fill(is_hit.begin(), is_hit.end(), 0);
+    for (int32_t i = 0; i < hierarchy_size_[0]; i++) {
+      int32_t num_pos = stages_[i].lab->Probe(feat_map, wnd_offset.data(),
+        num_x, kProbeNumBase, kProbeMargin, wnd_idx.data(), wnd_score.data());
+      for (int32_t k = 0; k < num_pos; k++)
+        is_hit[wnd_idx[k]] = 1;
+    }
+    num_probe += num_x;
+
+    // Flag the windows of the range within a coarse step of the hits
+    int32_t y1 = std::max(y - ratio_y + 1, wnd_range.y);
+    int32_t y2 = std::min(y + ratio_y, wnd_range.y + wnd_range.height);
+    for (int32_t k = 0; k < num_x; k++) {
+      if (is_hit[k] == 0)
+        continue;
+      int32_t x = probe_range.x + k * ratio_x;
+      int32_t x1 = std::max(x - ratio_x + 1, wnd_range.x);
+      int32_t x2 = std::min(x + ratio_x, wnd_range.x + wnd_range.width);
+      for (int32_t j = y1; x1 < x2 && j < y2; j++) {
+        std::memset(wnd_flag + (j - wnd_range.y) * wnd_range.width +
+          x1 - wnd_range.x, 1, x2 - x1);
+      }
+    }
+  }
+  return num_probe;
+}
+
+std::vector<seeta::FaceInfo> FuStDetector::RunFollowingClassifiers(
+    std::vector<std::vector<seeta::FaceInfo> >* proposals_buf,
+    const seeta::fd::ImagePyramid* img_pyramid,
+    seeta::fd::DetectionContext* ctx) const {
+  std::vector<std::vector<seeta::FaceInfo> > & proposals = *proposals_buf;
+  seeta::fd::StatsRecorder* stats_recorder = img_pyramid->stats_recorder();
+  int64_t start = (stats_recorder != nullptr ?
+    stats_recorder->GetElapsed() : 0);
 
   std::vector<std::vector<seeta::FaceInfo> > proposals_nms(hierarchy_size_[0]);
+  int64_t num_out = 0;
   for (int32_t i = 0; i < hierarchy_size_[0]; i++) {
     seeta::fd::NonMaximumSuppression(&(proposals[i]),
       &(proposals_nms[i]), 0.8f);
     proposals[i].clear();
+    num_out += static_cast<int64_t>(proposals_nms[i].size());
+  }
+  if (stats_recorder != nullptr) {
+    stats_recorder->AddNMSTime(0, stats_recorder->GetElapsed() - start);
+    stats_recorder->AddProposals(0, 0, num_out);
   }
 
   // Following classifiers
-  seeta::ImageData img = img_pyramid->image1x();
-  seeta::Rect roi;
-  std::vector<float> mlp_predicts(4);  // @todo no hard-coded number!
-  roi.x = roi.y = 0;
-  roi.width = roi.height = wnd_size_;
-
   int32_t cls_idx = hierarchy_size_[0];
   int32_t model_idx = hierarchy_size_[0];
   std::vector<int32_t> buf_idx;
 
   for (int32_t i = 1; i < num_hierarchy_; i++) {
+    int32_t stage_idx = 0;
     buf_idx.resize(hierarchy_size_[i]);
     for (int32_t j = 0; j < hierarchy_size_[i]; j++) {
       int32_t num_wnd_src = static_cast<int32_t>(wnd_src_id_[cls_idx].size());
-      std::vector<int32_t> & wnd_src = wnd_src_id_[cls_idx];
+      const std::vector<int32_t> & wnd_src = wnd_src_id_[cls_idx];
       buf_idx[j] = wnd_src[0];
       proposals[buf_idx[j]].clear();
       for (int32_t k = 0; k < num_wnd_src; k++) {
         proposals[buf_idx[j]].insert(proposals[buf_idx[j]].end(),
           proposals_nms[wnd_src[k]].begin(), proposals_nms[wnd_src[k]].end());
       }
+      int64_t num_in = static_cast<int64_t>(proposals[buf_idx[j]].size());
 
-      std::shared_ptr<seeta::fd::FeatureMap> & feat_map =
-        feat_map_[cls2feat_idx_[model_[model_idx]->type()]];
+      seeta::fd::FeatureMap* feat_map =
+        ctx->feat_map(stages_[model_idx].feat_map_idx);
       for (int32_t k = 0; k < num_stage_[cls_idx]; k++) {
-        int32_t num_wnd = static_cast<int32_t>(proposals[buf_idx[j]].size());
-        std::vector<seeta::FaceInfo> & bboxes = proposals[buf_idx[j]];
-        int32_t bbox_idx = 0;
-
-        for (int32_t m = 0; m < num_wnd; m++) {
-          if (bboxes[m].bbox.x + bboxes[m].bbox.width <= 0 ||
-              bboxes[m].bbox.y + bboxes[m].bbox.height <= 0)
-            continue;
-          GetWindowData(img, bboxes[m].bbox);
-          feat_map->Compute(wnd_data_.data(), wnd_size_, wnd_size_);
-          feat_map->SetROI(roi);
-
-          if (model_[model_idx]->Classify(&score, mlp_predicts.data())) {
-            float x = static_cast<float>(bboxes[m].bbox.x);
-            float y = static_cast<float>(bboxes[m].bbox.y);
-            float w = static_cast<float>(bboxes[m].bbox.width);
-            float h = static_cast<float>(bboxes[m].bbox.height);
-
-            bboxes[bbox_idx].bbox.width =
-              static_cast<int32_t>((mlp_predicts[3] * 2 - 1) * w + w + 0.5);
-            bboxes[bbox_idx].bbox.height = bboxes[bbox_idx].bbox.width;
-            bboxes[bbox_idx].bbox.x =
-              static_cast<int32_t>((mlp_predicts[1] * 2 - 1) * w + x +
-              (w - bboxes[bbox_idx].bbox.width) * 0.5 + 0.5);
-            bboxes[bbox_idx].bbox.y =
-              static_cast<int32_t>((mlp_predicts[2] * 2 - 1) * h + y +
-              (h - bboxes[bbox_idx].bbox.height) * 0.5 + 0.5);
-            bboxes[bbox_idx].score = score;
-            bbox_idx++;
-          }
+        int32_t bbox_idx;
+        if (stats_recorder != nullptr)
+          start = stats_recorder->GetElapsed();
+        if (img_pyramid->time_budget() == nullptr) {
+          bbox_idx = ClassifyWindows(img_pyramid, model_idx, feat_map, ctx,
+            &(proposals[buf_idx[j]]));
+        } else {
+          bbox_idx = ClassifyWindowsInBudget(img_pyramid, model_idx, feat_map,
+            ctx, &(proposals[buf_idx[j]]));
         }
         proposals[buf_idx[j]].resize(bbox_idx);
+        if (stats_recorder != nullptr) {
+          int64_t now = stats_recorder->GetElapsed();
+          stats_recorder->AddStageTime(i, stage_idx, now - start);
+          start = now;
+        }
 
         if (k < num_stage_[cls_idx] - 1) {
           seeta::fd::NonMaximumSuppression(&(proposals[buf_idx[j]]),
@@ -242,7 +948,14 @@ std::vector<seeta::FaceInfo> FuStDetector::Detect(
             proposals[buf_idx[j]] = proposals_nms[buf_idx[j]];
           }
         }
+        if (stats_recorder != nullptr)
+          stats_recorder->AddNMSTime(i, stats_recorder->GetElapsed() - start);
         model_idx++;
+        stage_idx++;
+      }
+      if (stats_recorder != nullptr) {
+        stats_recorder->AddProposals(i, num_in,
+          static_cast<int64_t>(proposals[buf_idx[j]].size()));
       }
 
       cls_idx++;
@@ -255,8 +968,232 @@ std::vector<seeta::FaceInfo> FuStDetector::Detect(
   return proposals_nms[0];
 }
 
+int32_t FuStDetector::ClassifyWindowsInBudget(
+    const seeta::fd::ImagePyramid* img_pyramid, int32_t model_idx,
+    seeta::fd::FeatureMap* feat_map, seeta::fd::DetectionContext* ctx,
+    std::vector<seeta::FaceInfo>* bboxes_buf) const {
+  seeta::fd::TimeBudget* time_budget = img_pyramid->time_budget();
+  std::vector<float> & wnd_cost = *(ctx->wnd_cost());
+  std::vector<float> & wnd_count = *(ctx->wnd_count());
+  std::vector<seeta::FaceInfo> & bboxes = *bboxes_buf;
+  std::vector<seeta::FaceInfo> chunk;
+
+  // Cost of the following models per window of this one, i.e. the later
+  // stages of its classifier and the models of the later hierarchies, each
+  // of them seeing about as many windows, relative to this model, as in
+  // previous calls on the context. Unmeasured models are charged every
+  // window. Other classifiers of the hierarchy never see these windows.
+  const CascadeStage & stage = stages_[model_idx];
+  float later_cost = 0.0f;
+  int32_t num_model = static_cast<int32_t>(wnd_cost.size());
+  for (int32_t i = model_idx + 1; i < num_model; i++) {
+    if (i == stage.branch_end)
+      i = stage.hierarchy_end;
+    if (i >= num_model)
+      break;
+    float ratio = (wnd_count[model_idx] > 0.0f ?
+      std::min(wnd_count[i] / wnd_count[model_idx], 1.0f) : 1.0f);
+    later_cost += wnd_cost[i] * ratio;
+  }
+
+  // Windows are classified in chunks. Before each chunk, the worst scoring
+  // of the windows left that this and the following models are not expected
+  // to take in the remaining time are dropped, the cost per window being
+  // measured on the previous chunks, or taken from previous calls on the
+  // context. Windows keep their order, so that the result is the same as
+  // that of `ClassifyWindows()` when none is dropped.
+  float model_cost = wnd_cost[model_idx];
+  int64_t start = time_budget->GetElapsed();
+  size_t num_done = 0;
+  int32_t bbox_idx = 0;
+  while (num_done < bboxes.size()) {
+    float cost = model_cost + later_cost;
+    int64_t remaining = time_budget->GetRemaining();
+    size_t max_num_wnd = bboxes.size();
+    if (remaining <= 0)
+      max_num_wnd = num_done;
+    else if (cost > 0.0f)
+      max_num_wnd = std::min(max_num_wnd,
+        num_done + static_cast<size_t>(remaining / cost));
+    if (max_num_wnd < bboxes.size()) {
+      KeepBestScoring(&bboxes, num_done, max_num_wnd - num_done);
+      time_budget->SetPartial();
+      if (num_done == max_num_wnd)
+        break;
+    }
+
+    size_t num_chunk = std::min(bboxes.size() - num_done, kBudgetChunkSize);
+    chunk.assign(bboxes.begin() + num_done,
+      bboxes.begin() + num_done + num_chunk);
+    int32_t num_pass = ClassifyWindows(img_pyramid, model_idx, feat_map, ctx,
+      &chunk);
+    std::copy(chunk.begin(), chunk.begin() + num_pass,
+      bboxes.begin() + bbox_idx);
+    bbox_idx += num_pass;
+    num_done += num_chunk;
+    model_cost = static_cast<float>(time_budget->GetElapsed() - start) /
+      static_cast<float>(num_done);
+  }
+
+  if (num_done > 0) {
+    wnd_cost[model_idx] = (wnd_cost[model_idx] > 0.0f ?
+      0.5f * (wnd_cost[model_idx] + model_cost) : model_cost);
+  }
+  float count = static_cast<float>(num_done);
+  wnd_count[model_idx] = (wnd_count[model_idx] > 0.0f ?
+    0.5f * (wnd_count[model_idx] + count) : count);
+  return bbox_idx;
+}
+
+int32_t FuStDetector::ClassifyWindows(
+    const seeta::fd::ImagePyramid* img_pyramid, int32_t model_idx,
+    seeta::fd::FeatureMap* feat_map, seeta::fd::DetectionContext* ctx,
+    std::vector<seeta::FaceInfo>* bboxes_buf) const {
+  std::vector<seeta::FaceInfo> & bboxes = *bboxes_buf;
+  int32_t num_wnd = static_cast<int32_t>(bboxes.size());
+  int32_t wnd_size = ctx->wnd_size();
+  int32_t bbox_idx = 0;
+  seeta::Rect roi;
+  roi.x = roi.y = 0;
+  roi.width = roi.height = wnd_size;
+
+  if (stages_[model_idx].surf_mlp == nullptr) {
+    const seeta::fd::LABBoostedClassifier* lab = stages_[model_idx].lab;
+    seeta::fd::LABFeatureMap* lab_feat_map =
+      static_cast<seeta::fd::LABFeatureMap*>(feat_map);
+    std::vector<float> & mlp_predicts = *(ctx->mlp_output_buf());
+    float score;
+    mlp_predicts.resize(4);  // @todo no hard-coded number!
+    for (int32_t m = 0; m < num_wnd; m++) {
+      if (bboxes[m].bbox.x + bboxes[m].bbox.width <= 0 ||
+          bboxes[m].bbox.y + bboxes[m].bbox.height <= 0)
+        continue;
+      GetWindowData(img_pyramid, bboxes[m].bbox, ctx);
+      lab_feat_map->Compute(ctx->wnd_data()->data(), wnd_size, wnd_size);
+      lab_feat_map->SetROI(roi);
+      if (lab->Classify(lab_feat_map, &score, mlp_predicts.data()))
+        RegressBBox(bboxes[m], mlp_predicts.data(), score, &bboxes[bbox_idx++]);
+    }
+    return bbox_idx;
+  }
+
+  // Gather the features of all windows into a matrix and run the network on
+  // it as a whole, one layer at a time.
+  const seeta::fd::SURFMLP* mlp = stages_[model_idx].surf_mlp;
+  seeta::fd::SURFFeatureMap* surf_feat_map =
+    static_cast<seeta::fd::SURFFeatureMap*>(feat_map);
+  int32_t input_dim = mlp->GetInputDim();
+  int32_t output_dim = mlp->GetOutputDim();
+  std::vector<float> & input = *(ctx->mlp_input_buf());
+  std::vector<float> & outputs = *(ctx->mlp_output_buf());
+  std::vector<float> & layer_buf = *(ctx->mlp_layer_buf());
+  std::vector<int32_t> wnd_idx;
+  std::vector<WindowGroup> wnd_groups;
+  int64_t max_group_area = (ctx->tile_memory_limit() > 0 ?
+    std::max<int64_t>(ctx->tile_memory_limit() / kGroupBytesPerPixel,
+    static_cast<int64_t>(wnd_size) * wnd_size) :
+    std::numeric_limits<int64_t>::max());
+
+  input.resize(static_cast<size_t>(num_wnd) * input_dim);
+  wnd_idx.reserve(num_wnd);
+  for (int32_t m = 0; m < num_wnd; m++) {
+    if (bboxes[m].bbox.x + bboxes[m].bbox.width <= 0 ||
+        bboxes[m].bbox.y + bboxes[m].bbox.height <= 0)
+      continue;
+    LevelWindow level_wnd;
+    int32_t level;
+    level_wnd.row = static_cast<int32_t>(wnd_idx.size());
+    wnd_idx.push_back(m);
+
+    // Windows lying inside a pyramid level are handled below, and those
+    // crossing the image border get zero-padded crops as before.
+    if (use_pyramid_surf_ && MapToPyramidLevel(*img_pyramid, bboxes[m].bbox,
+        wnd_size, &level, &(level_wnd.roi))) {
+      AddToWindowGroup(level, level_wnd, wnd_size, max_group_area, &wnd_groups);
+      continue;
+    }
+    GetWindowData(img_pyramid, bboxes[m].bbox, ctx);
+    surf_feat_map->Compute(ctx->wnd_data()->data(), wnd_size, wnd_size);
+    surf_feat_map->SetROI(roi);
+    mlp->GetFeatureVector(surf_feat_map,
+      input.data() + level_wnd.row * input_dim);
+  }
+
+  // The integral images of a group cover the bounding box of its windows,
+  // whose features are then read at their offsets within it.
+  std::vector<uint8_t> & group_data = *(ctx->wnd_data_buf());
+  for (size_t g = 0; g < wnd_groups.size(); g++) {
+    const WindowGroup & group = wnd_groups[g];
+    seeta::ImageData group_img(group.rect.width, group.rect.height, 1);
+    group_data.resize(group.rect.width * group.rect.height);
+    group_img.data = group_data.data();
+    img_pyramid->GetScaleRegion(group.level, group.rect, ctx->resizer(),
+      &group_img);
+    surf_feat_map->Compute(group_data.data(), group.rect.width,
+      group.rect.height);
+
+    for (size_t n = 0; n < group.wnds.size(); n++) {
+      seeta::Rect wnd_roi = group.wnds[n].roi;
+      wnd_roi.x -= group.rect.x;
+      wnd_roi.y -= group.rect.y;
+      surf_feat_map->SetROI(wnd_roi);
+      mlp->GetFeatureVector(surf_feat_map,
+        input.data() + group.wnds[n].row * input_dim);
+    }
+  }
+
+  int32_t num = static_cast<int32_t>(wnd_idx.size());
+  outputs.resize(static_cast<size_t>(num) * output_dim);
+  layer_buf.resize(static_cast<size_t>(num) * mlp->GetBufferSize());
+  mlp->Classify(input.data(), num, outputs.data(), layer_buf.data());
+
+  for (int32_t n = 0; n < num; n++) {
+    const float* mlp_predicts = outputs.data() + n * output_dim;
+    if (mlp_predicts[0] > mlp->threshold()) {
+      RegressBBox(bboxes[wnd_idx[n]], mlp_predicts, mlp_predicts[0],
+        &bboxes[bbox_idx++]);
+    }
+  }
+  return bbox_idx;
+}
+
+void FuStDetector::RegressBBox(const seeta::FaceInfo & wnd,
+    const float* mlp_predicts, float score, seeta::FaceInfo* face) {
+  float x = static_cast<float>(wnd.bbox.x);
+  float y = static_cast<float>(wnd.bbox.y);
+  float w = static_cast<float>(wnd.bbox.width);
+  float h = static_cast<float>(wnd.bbox.height);
+
+  face->bbox.width =
+    static_cast<int32_t>((mlp_predicts[3] * 2 - 1) * w + w + 0.5);
+  face->bbox.height = face->bbox.width;
+  face->bbox.x = static_cast<int32_t>((mlp_predicts[1] * 2 - 1) * w + x +
+    (w - face->bbox.width) * 0.5 + 0.5);
+  face->bbox.y = static_cast<int32_t>((mlp_predicts[2] * 2 - 1) * h + y +
+    (h - face->bbox.height) * 0.5 + 0.5);
+  face->score = score;
+}
+
+void FuStDetector::SetUseInt16Weights(bool use) {
+  for (size_t i = 0; i < model_.size(); i++) {
+    if (model_[i]->type() == seeta::fd::ClassifierType::LAB_Boosted_Classifier) {
+      static_cast<seeta::fd::LABBoostedClassifier*>(model_[i].get())->
+        SetUseInt16Weights(use);
+    }
+  }
+}
+
+void FuStDetector::SetUseInt8Weights(bool use) {
+  for (size_t i = 0; i < model_.size(); i++) {
+    if (model_[i]->type() == seeta::fd::ClassifierType::SURF_MLP) {
+      static_cast<seeta::fd::SURFMLP*>(model_[i].get())->
+        SetUseInt8Weights(use);
+    }
+  }
+}
+
 std::shared_ptr<seeta::fd::ModelReader>
-FuStDetector::CreateModelReader(seeta::fd::ClassifierType type) {
+FuStDetector::CreateModelReader(seeta::fd::ClassifierType type) const {
   std::shared_ptr<seeta::fd::ModelReader> reader;
   switch (type) {
   case seeta::fd::ClassifierType::LAB_Boosted_Classifier:
@@ -272,7 +1209,7 @@ FuStDetector::CreateModelReader(seeta::fd::ClassifierType type) {
 }
 
 std::shared_ptr<seeta::fd::Classifier>
-FuStDetector::CreateClassifier(seeta::fd::ClassifierType type) {
+FuStDetector::CreateClassifier(seeta::fd::ClassifierType type) const {
   std::shared_ptr<seeta::fd::Classifier> classifier;
   switch (type) {
   case seeta::fd::ClassifierType::LAB_Boosted_Classifier:
@@ -288,7 +1225,7 @@ FuStDetector::CreateClassifier(seeta::fd::ClassifierType type) {
 }
 
 std::shared_ptr<seeta::fd::FeatureMap>
-FuStDetector::CreateFeatureMap(seeta::fd::ClassifierType type) {
+FuStDetector::CreateFeatureMap(seeta::fd::ClassifierType type) const {
   std::shared_ptr<seeta::fd::FeatureMap> feat_map;
   switch (type) {
   case seeta::fd::ClassifierType::LAB_Boosted_Classifier:
@@ -303,8 +1240,12 @@ FuStDetector::CreateFeatureMap(seeta::fd::ClassifierType type) {
   return feat_map;
 }
 
-void FuStDetector::GetWindowData(const seeta::ImageData & img,
-    const seeta::Rect & wnd) {
+void FuStDetector::GetWindowData(const seeta::fd::ImagePyramid* img_pyramid,
+    const seeta::Rect & wnd, seeta::fd::DetectionContext* ctx) const {
+  const seeta::ImageData img = img_pyramid->image1x();
+  std::vector<uint8_t> & wnd_data_buf = *(ctx->wnd_data_buf());
+  std::vector<uint8_t> & wnd_data = *(ctx->wnd_data());
+  int32_t wnd_size = ctx->wnd_size();
   int32_t pad_left;
   int32_t pad_right;
   int32_t pad_top;
@@ -325,9 +1266,10 @@ void FuStDetector::GetWindowData(const seeta::ImageData & img,
     roi.y = 0;
   }
 
-  wnd_data_buf_.resize(roi.width * roi.height);
-  const uint8_t* src = img.data + roi.y * img.width + roi.x;
-  uint8_t* dest = wnd_data_buf_.data();
+  wnd_data_buf.resize(roi.width * roi.height);
+  wnd_data.resize(wnd_size * wnd_size);
+  int32_t src_y = roi.y;
+  uint8_t* dest = wnd_data_buf.data();
   int32_t len = sizeof(uint8_t) * roi.width;
   int32_t len2 = sizeof(uint8_t) * (roi.width - pad_left - pad_right);
 
@@ -338,14 +1280,14 @@ void FuStDetector::GetWindowData(const seeta::ImageData & img,
   if (pad_left == 0) {
     if (pad_right == 0) {
       for (int32_t y = pad_top; y < roi.height - pad_bottom; y++) {
-        std::memcpy(dest, src, len);
-        src += img.width;
+        img_pyramid->GetGrayRow1x(roi.x, src_y, len, dest);
+        src_y++;
         dest += roi.width;
       }
     } else {
       for (int32_t y = pad_top; y < roi.height - pad_bottom; y++) {
-        std::memcpy(dest, src, len2);
-        src += img.width;
+        img_pyramid->GetGrayRow1x(roi.x, src_y, len2, dest);
+        src_y++;
         dest += roi.width;
         std::memset(dest - pad_right, 0, sizeof(uint8_t) * pad_right);
       }
@@ -354,15 +1296,15 @@ void FuStDetector::GetWindowData(const seeta::ImageData & img,
     if (pad_right == 0) {
       for (int32_t y = pad_top; y < roi.height - pad_bottom; y++) {
         std::memset(dest, 0, sizeof(uint8_t)* pad_left);
-        std::memcpy(dest + pad_left, src, len2);
-        src += img.width;
+        img_pyramid->GetGrayRow1x(roi.x, src_y, len2, dest + pad_left);
+        src_y++;
         dest += roi.width;
       }
     } else {
       for (int32_t y = pad_top; y < roi.height - pad_bottom; y++) {
         std::memset(dest, 0, sizeof(uint8_t) * pad_left);
-        std::memcpy(dest + pad_left, src, len2);
-        src += img.width;
+        img_pyramid->GetGrayRow1x(roi.x, src_y, len2, dest + pad_left);
+        src_y++;
         dest += roi.width;
         std::memset(dest - pad_right, 0, sizeof(uint8_t) * pad_right);
       }
@@ -372,10 +1314,10 @@ void FuStDetector::GetWindowData(const seeta::ImageData & img,
     std::memset(dest, 0, len * pad_bottom);
 
   seeta::ImageData src_img(roi.width, roi.height);
-  seeta::ImageData dest_img(wnd_size_, wnd_size_);
-  src_img.data = wnd_data_buf_.data();
-  dest_img.data = wnd_data_.data();
-  seeta::fd::ResizeImage(src_img, &dest_img);
+  seeta::ImageData dest_img(wnd_size, wnd_size);
+  src_img.data = wnd_data_buf.data();
+  dest_img.data = wnd_data.data();
+  seeta::fd::ResizeImage(src_img, &dest_img, ctx->executor());
 }
 
 }  // namespace fd
@@ -31,8 +31,6 @@
 
 #include "io/lab_boost_model_reader.h"
 
-#include <vector>
-
 namespace seeta {
 namespace fd {
 
@@ -45,39 +43,37 @@ bool LABBoostModelReader::Read(std::istream* input,
   input->read(reinterpret_cast<char*>(&num_base_classifer_), sizeof(int32_t));
   input->read(reinterpret_cast<char*>(&num_bin_), sizeof(int32_t));
 
-  is_read = (!input->fail()) && num_base_classifer_ > 0 && num_bin_ > 0 &&
-    ReadFeatureParam(input, lab_boosted_classifier) &&
-    ReadBaseClassifierParam(input, lab_boosted_classifier);
+  is_read = (!input->fail()) && num_base_classifer_ > 0 && num_bin_ > 0;
+  if (is_read) {
+    seeta::fd::LABModelTable* table = lab_boosted_classifier->table();
+    table->Reset(num_base_classifer_, num_bin_);
+    is_read = ReadFeatureParam(input, table) &&
+      ReadBaseClassifierParam(input, table);
+  }
 
   return is_read;
 }
 
 bool LABBoostModelReader::ReadFeatureParam(std::istream* input,
-    seeta::fd::LABBoostedClassifier* model) {
-  int32_t x;
-  int32_t y;
+    seeta::fd::LABModelTable* table) {
+  seeta::fd::LABFeature* feat = table->feat();
   for (int32_t i = 0; i < num_base_classifer_; i++) {
-    input->read(reinterpret_cast<char*>(&x), sizeof(int32_t));
-    input->read(reinterpret_cast<char*>(&y), sizeof(int32_t));
-    model->AddFeature(x, y);
+    input->read(reinterpret_cast<char*>(&(feat[i].x)), sizeof(int32_t));
+    input->read(reinterpret_cast<char*>(&(feat[i].y)), sizeof(int32_t));
   }
 
   return !input->fail();
 }
 
 bool LABBoostModelReader::ReadBaseClassifierParam(std::istream* input,
-    seeta::fd::LABBoostedClassifier* model) {
-  std::vector<float> thresh;
-  thresh.resize(num_base_classifer_);
-  input->read(reinterpret_cast<char*>(thresh.data()),
+    seeta::fd::LABModelTable* table) {
+  input->read(reinterpret_cast<char*>(table->thresh()),
     sizeof(float)* num_base_classifer_);
 
   int32_t weight_len = sizeof(float)* (num_bin_ + 1);
-  std::vector<float> weights;
-  weights.resize(num_bin_ + 1);
   for (int32_t i = 0; i < num_base_classifer_; i++) {
-    input->read(reinterpret_cast<char*>(weights.data()), weight_len);
-    model->AddBaseClassifier(weights.data(), num_bin_, thresh[i]);
+    input->read(reinterpret_cast<char*>(table->weights() +
+      i * table->weight_stride()), weight_len);
   }
 
   return !input->fail();
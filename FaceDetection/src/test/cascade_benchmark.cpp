@@ -0,0 +1,170 @@
+/*
+ *
+ * This file is part of the open-source SeetaFace engine, which includes three modules:
+ * SeetaFace Detection, SeetaFace Alignment, and SeetaFace Identification.
+ *
+ * This file is part of the SeetaFace Detection module, containing codes implementing the
+ * face detection method described in the following paper:
+ *
+ *
+ *   Funnel-structured cascade for multi-view face detection with alignment awareness,
+ *   Shuzhe Wu, Meina Kan, Zhenliang He, Shiguang Shan, Xilin Chen.
+ *   In Neurocomputing (under review)
+ *
+ *
+ * Copyright (C) 2016, Visual Information Processing and Learning (VIPL) group,
+ * Institute of Computing Technology, Chinese Academy of Sciences, Beijing, China.
+ *
+ * The codes are mainly developed by Shuzhe Wu (a Ph.D supervised by Prof. Shiguang Shan)
+ *
+ * As an open-source face recognition engine: you can redistribute SeetaFace source codes
+ * and/or modify it under the terms of the BSD 2-Clause License.
+ *
+ * You should have received a copy of the BSD 2-Clause License along with the software.
+ * If not, see < https://opensource.org/licenses/BSD-2-Clause>.
+ *
+ * Contact Info: you can send an email to SeetaFace@vipl.ict.ac.cn for any problems.
+ *
+ * Note: the above information must be kept whenever or wherever the codes are used.
+ *
+ */
+
+
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "common.h"
+#include "classifier/lab_boosted_classifier.h"
+#include "feat/lab_feature_map.h"
+
+using namespace std;
+
+static const int32_t kWndSize = 40;
+static const int32_t kStep = 4;
+static const int32_t kImageWidth = 640;
+static const int32_t kImageHeight = 480;
+
+/**
+ * A LAB boosted classifier of `num_base` base classifiers with random
+ * features and weights, whose thresholds reject windows along the way as
+ * the stages of the cascade do.
+ */
+static void InitClassifier(int32_t num_base, std::mt19937* rng,
+    seeta::fd::LABBoostedClassifier* classifier) {
+  std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+  std::uniform_int_distribution<int32_t> pos(0, kWndSize - 9);
+  seeta::fd::LABModelTable* table = classifier->table();
+  table->Reset(num_base, 255);
+  for (int32_t i = 0; i < num_base; i++) {
+    table->feat()[i].x = pos(*rng);
+    table->feat()[i].y = pos(*rng);
+    table->thresh()[i] = -0.5f * (i + 1) / 10;
+    for (int32_t j = 0; j < table->weight_stride(); j++)
+      table->weights()[i * table->weight_stride() + j] = uniform(*rng);
+  }
+  classifier->SetUseStdDev(false);
+}
+
+/**
+ * Classify all windows one by one through the `Classifier` interface, as the
+ * cascade did before its stages were resolved at load time.
+ */
+static int32_t ClassifyVirtual(
+    const std::shared_ptr<seeta::fd::Classifier> & classifier,
+    seeta::fd::FeatureMap* feat_map, float* score_sum) {
+  seeta::Rect roi;
+  int32_t num_pos = 0;
+  float score;
+  roi.width = roi.height = kWndSize;
+  for (roi.y = 0; roi.y + kWndSize <= kImageHeight; roi.y += kStep) {
+    for (roi.x = 0; roi.x + kWndSize <= kImageWidth; roi.x += kStep) {
+      feat_map->SetROI(roi);
+      if (classifier->Classify(feat_map, &score)) {
+        num_pos++;
+        *score_sum += score;
+      }
+    }
+  }
+  return num_pos;
+}
+
+/** Same as above, calling the concrete classes directly */
+static int32_t ClassifyDirect(
+    const seeta::fd::LABBoostedClassifier & classifier,
+    seeta::fd::LABFeatureMap* feat_map, float* score_sum) {
+  seeta::Rect roi;
+  int32_t num_pos = 0;
+  float score;
+  roi.width = roi.height = kWndSize;
+  for (roi.y = 0; roi.y + kWndSize <= kImageHeight; roi.y += kStep) {
+    for (roi.x = 0; roi.x + kWndSize <= kImageWidth; roi.x += kStep) {
+      feat_map->SetROI(roi);
+      if (classifier.Classify(feat_map, &score)) {
+        num_pos++;
+        *score_sum += score;
+      }
+    }
+  }
+  return num_pos;
+}
+
+/** Best time in milliseconds of a few runs, with the result of the last one */
+template<typename Func>
+static double Time(Func func, int32_t* num_pos, float* score_sum) {
+  double best = 0;
+  for (int32_t i = 0; i < 5; i++) {
+    *score_sum = 0.0f;
+    auto start = std::chrono::steady_clock::now();
+    *num_pos = func(score_sum);
+    auto end = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    if (i == 0 || ms < best)
+      best = ms;
+  }
+  return best;
+}
+
+int main(int argc, char** argv) {
+  const int32_t num_base[] = { 10, 50, 150 };
+  std::mt19937 rng(2016);
+  std::uniform_int_distribution<int32_t> pixel(0, 255);
+  bool all_same = true;
+
+  vector<uint8_t> img(kImageWidth * kImageHeight);
+  for (size_t i = 0; i < img.size(); i++)
+    img[i] = static_cast<uint8_t>(pixel(rng));
+  seeta::fd::LABFeatureMap feat_map;
+  feat_map.Compute(img.data(), kImageWidth, kImageHeight);
+
+  cout << "num_base\tvirtual_ms\tdirect_ms\tspeedup\tsame" << endl;
+  for (int32_t i = 0; i < 3; i++) {
+    std::shared_ptr<seeta::fd::LABBoostedClassifier> classifier(
+      new seeta::fd::LABBoostedClassifier());
+    std::shared_ptr<seeta::fd::Classifier> model = classifier;
+    InitClassifier(num_base[i], &rng, classifier.get());
+
+    int32_t num_pos_virtual;
+    int32_t num_pos_direct;
+    float sum_virtual;
+    float sum_direct;
+    double ms_virtual = Time([&](float* sum) {
+      return ClassifyVirtual(model, &feat_map, sum);
+    }, &num_pos_virtual, &sum_virtual);
+    double ms_direct = Time([&](float* sum) {
+      return ClassifyDirect(*classifier, &feat_map, sum);
+    }, &num_pos_direct, &sum_direct);
+    bool same = (num_pos_virtual == num_pos_direct &&
+      std::memcmp(&sum_virtual, &sum_direct, sizeof(float)) == 0);
+    all_same = all_same && same;
+    cout << num_base[i] << "\t" << ms_virtual << "\t" << ms_direct << "\t"
+      << ms_virtual / ms_direct << "\t" << (same ? "yes" : "NO") << endl;
+  }
+
+  return (all_same ? 0 : 1);
+}
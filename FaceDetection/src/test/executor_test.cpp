@@ -0,0 +1,77 @@
+/*
+ *
+ * This file is part of the open-source SeetaFace engine, which includes three modules:
+ * SeetaFace Detection, SeetaFace Alignment, and SeetaFace Identification.
+ *
+ * This file is part of the SeetaFace Detection module, containing codes implementing the
+ * face detection method described in the following paper:
+ *
+ *
+ *   Funnel-structured cascade for multi-view face detection with alignment awareness,
+ *   Shuzhe Wu, Meina Kan, Zhenliang He, Shiguang Shan, Xilin Chen.
+ *   In Neurocomputing (under review)
+ *
+ *
+ * Copyright (C) 2016, Visual Information Processing and Learning (VIPL) group,
+ * Institute of Computing Technology, Chinese Academy of Sciences, Beijing, China.
+ *
+ * The codes are mainly developed by Shuzhe Wu (a Ph.D supervised by Prof. Shiguang Shan)
+ *
+ * As an open-source face recognition engine: you can redistribute SeetaFace source codes
+ * and/or modify it under the terms of the BSD 2-Clause License.
+ *
+ * You should have received a copy of the BSD 2-Clause License along with the software.
+ * If not, see < https://opensource.org/licenses/BSD-2-Clause>.
+ *
+ * Contact Info: you can send an email to SeetaFace@vipl.ict.ac.cn for any problems.
+ *
+ * Note: the above information must be kept whenever or wherever the codes are used.
+ *
+ */
+
+
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+
+#include "executor.h"
+
+using namespace std;
+
+/**
+ * Loops nested `depth` levels deep on the same executor, as when its tasks
+ * call `Detect()` on a detector given that executor. Returns the number of
+ * innermost tasks run.
+ */
+static int64_t RunNested(seeta::Executor* executor, int32_t num_tasks,
+    int32_t depth) {
+  std::atomic<int64_t> num_run(0);
+  executor->ParallelFor(num_tasks, [&](int32_t i) {
+    num_run += (depth > 1 ? RunNested(executor, num_tasks, depth - 1) : 1);
+  });
+  return num_run;
+}
+
+int main(int argc, char** argv) {
+  int32_t num_failed = 0;
+  for (int32_t num_threads = 1; num_threads <= 4; num_threads++) {
+    std::shared_ptr<seeta::Executor> executor =
+      seeta::CreateThreadPoolExecutor(num_threads);
+    for (int32_t depth = 1; depth <= 3; depth++) {
+      int32_t num_tasks = num_threads * 2;
+      int64_t expected = 1;
+      for (int32_t i = 0; i < depth; i++)
+        expected *= num_tasks;
+      int64_t num_run = RunNested(executor.get(), num_tasks, depth);
+      bool is_ok = (num_run == expected);
+      cout << "threads " << num_threads << ", depth " << depth << ": "
+        << num_run << " of " << expected << " tasks run"
+        << (is_ok ? "" : "  FAILED") << endl;
+      if (!is_ok)
+        num_failed++;
+    }
+  }
+  return num_failed > 0 ? 1 : 0;
+}
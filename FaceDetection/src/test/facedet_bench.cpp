@@ -0,0 +1,582 @@
+/*
+ *
+ * This file is part of the open-source SeetaFace engine, which includes three modules:
+ * SeetaFace Detection, SeetaFace Alignment, and SeetaFace Identification.
+ *
+ * This file is part of the SeetaFace Detection module, containing codes implementing the
+ * face detection method described in the following paper:
+ *
+ *
+ *   Funnel-structured cascade for multi-view face detection with alignment awareness,
+ *   Shuzhe Wu, Meina Kan, Zhenliang He, Shiguang Shan, Xilin Chen.
+ *   In Neurocomputing (under review)
+ *
+ *
+ * Copyright (C) 2016, Visual Information Processing and Learning (VIPL) group,
+ * Institute of Computing Technology, Chinese Academy of Sciences, Beijing, China.
+ *
+ * The codes are mainly developed by Shuzhe Wu (a Ph.D supervised by Prof. Shiguang Shan)
+ *
+ * As an open-source face recognition engine: you can redistribute SeetaFace source codes
+ * and/or modify it under the terms of the BSD 2-Clause License.
+ *
+ * You should have received a copy of the BSD 2-Clause License along with the software.
+ * If not, see < https://opensource.org/licenses/BSD-2-Clause>.
+ *
+ * Contact Info: you can send an email to SeetaFace@vipl.ict.ac.cn for any problems.
+ *
+ * Note: the above information must be kept whenever or wherever the codes are used.
+ *
+ */
+
+
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "common.h"
+#include "detection_stats.h"
+#include "face_detection.h"
+#include "util/image_resizer.h"
+#include "util/simd_kernels.h"
+
+using namespace std;
+
+/** An input image, with its pixels */
+typedef struct BenchImage {
+  string name;
+  int32_t width;
+  int32_t height;
+  vector<uint8_t> data;
+} BenchImage;
+
+/** Settings swept by the benchmark */
+typedef struct BenchOptions {
+  string model_path;
+  vector<string> image_paths;
+  vector<pair<int32_t, int32_t> > sizes;
+  vector<int32_t> min_face_sizes;
+  vector<float> scale_factors;
+  vector<int32_t> window_steps;
+  vector<int32_t> coarse_steps;
+  vector<int32_t> num_threads;
+  int32_t num_iter;
+  int32_t num_warmup;
+  int64_t tile_memory;
+} BenchOptions;
+
+static void PrintUsage(const char* prog) {
+  cerr << "Usage: " << prog << " model_path [options] [image ...]\n"
+    "  Images are binary PGM (P5) files, or raw 8-bit gray files given as\n"
+    "  path@WIDTHxHEIGHT. Without images, synthetic ones are generated.\n"
+    "  --sizes WxH,...         resize the images to these sizes\n"
+    "                          (default for synthetic images:\n"
+    "                          640x480,1280x720,1920x1080)\n"
+    "  --min-face N,...        minimum face sizes (default 40)\n"
+    "  --scale F,...           pyramid scale factors (default 0.8)\n"
+    "  --step N,...            sliding window steps (default 4)\n"
+    "  --coarse-step N,...     coarse-to-fine grid steps, 0 for off\n"
+    "                          (default 0); recall is measured against\n"
+    "                          the faces found with 0\n"
+    "  --threads N,...         thread counts (default 1)\n"
+    "  --iters N               timed runs per image (default 10)\n"
+    "  --warmup N              untimed runs per image (default 2)\n"
+    "  --tile-memory BYTES     tile memory limit of the sliding window,\n"
+    "                          0 for no tiling (default 0)\n"
+    "Results are written to stdout as JSON.\n";
+}
+
+static vector<string> Split(const string & str, char sep) {
+  vector<string> items;
+  stringstream ss(str);
+  string item;
+  while (getline(ss, item, sep)) {
+    if (!item.empty())
+      items.push_back(item);
+  }
+  return items;
+}
+
+static bool ParseSize(const string & str, pair<int32_t, int32_t>* size) {
+  return sscanf(str.c_str(), "%dx%d", &(size->first), &(size->second)) == 2 &&
+    size->first > 0 && size->second > 0;
+}
+
+static bool ParseOptions(int argc, char** argv, BenchOptions* options) {
+  if (argc < 2)
+    return false;
+  options->model_path = argv[1];
+  options->num_iter = 10;
+  options->num_warmup = 2;
+  options->tile_memory = 0;
+
+  for (int i = 2; i < argc; i++) {
+    string arg = argv[i];
+    if (arg.compare(0, 2, "--") != 0) {
+      options->image_paths.push_back(arg);
+      continue;
+    }
+    if (i + 1 >= argc)
+      return false;
+    vector<string> values = Split(argv[++i], ',');
+    if (values.empty())
+      return false;
+    for (size_t j = 0; j < values.size(); j++) {
+      const char* value = values[j].c_str();
+      if (arg == "--sizes") {
+        pair<int32_t, int32_t> size;
+        if (!ParseSize(values[j], &size))
+          return false;
+        options->sizes.push_back(size);
+      } else if (arg == "--min-face") {
+        options->min_face_sizes.push_back(atoi(value));
+      } else if (arg == "--scale") {
+        options->scale_factors.push_back(static_cast<float>(atof(value)));
+      } else if (arg == "--step") {
+        options->window_steps.push_back(atoi(value));
+      } else if (arg == "--coarse-step") {
+        options->coarse_steps.push_back(max(atoi(value), 0));
+      } else if (arg == "--threads") {
+        options->num_threads.push_back(atoi(value));
+      } else if (arg == "--iters") {
+        options->num_iter = max(atoi(value), 1);
+      } else if (arg == "--warmup") {
+        options->num_warmup = max(atoi(value), 0);
+      } else if (arg == "--tile-memory") {
+        options->tile_memory = max(atoll(value), 0LL);
+      } else {
+        return false;
+      }
+    }
+  }
+
+  if (options->min_face_sizes.empty())
+    options->min_face_sizes.push_back(40);
+  if (options->scale_factors.empty())
+    options->scale_factors.push_back(0.8f);
+  if (options->window_steps.empty())
+    options->window_steps.push_back(4);
+  if (options->coarse_steps.empty())
+    options->coarse_steps.push_back(0);
+  if (options->num_threads.empty())
+    options->num_threads.push_back(1);
+  return true;
+}
+
+/** Read a binary PGM file, or a raw gray one given as path@WIDTHxHEIGHT */
+static bool ReadImage(const string & spec, BenchImage* img) {
+  string path = spec;
+  pair<int32_t, int32_t> raw_size(0, 0);
+  size_t at = spec.rfind('@');
+  if (at != string::npos) {
+    path = spec.substr(0, at);
+    if (!ParseSize(spec.substr(at + 1), &raw_size))
+      return false;
+  }
+
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == nullptr)
+    return false;
+  bool is_read = true;
+  if (raw_size.first > 0) {
+    img->width = raw_size.first;
+    img->height = raw_size.second;
+  } else {
+    int32_t max_val;
+    is_read = (fscanf(file, "P5 %d %d %d", &(img->width), &(img->height),
+      &max_val) == 3 && max_val == 255 && fgetc(file) != EOF);
+  }
+  if (is_read) {
+    img->data.resize(static_cast<size_t>(img->width) * img->height);
+    is_read = (fread(img->data.data(), 1, img->data.size(), file) ==
+      img->data.size());
+  }
+  fclose(file);
+  img->name = path;
+  return is_read;
+}
+
+/**
+ * A textured image: smooth shading plus blobs and noise, so that the cascade
+ * rejects windows at various stages as on natural images. It holds no faces,
+ * so the later stages only see false alarms.
+ */
+static BenchImage GenerateImage(int32_t width, int32_t height, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+  std::normal_distribution<float> noise(0.0f, 8.0f);
+  BenchImage img;
+  ostringstream name;
+  name << "synthetic_" << width << "x" << height;
+  img.name = name.str();
+  img.width = width;
+  img.height = height;
+  img.data.resize(static_cast<size_t>(width) * height);
+
+  int32_t num_blob = 32;
+  vector<float> blob(num_blob * 4);
+  for (int32_t i = 0; i < num_blob; i++) {
+    blob[i * 4] = uniform(rng) * width;
+    blob[i * 4 + 1] = uniform(rng) * height;
+    blob[i * 4 + 2] = 10.0f + uniform(rng) * min(width, height) / 6.0f;
+    blob[i * 4 + 3] = (uniform(rng) - 0.5f) * 160.0f;
+  }
+  for (int32_t y = 0; y < height; y++) {
+    for (int32_t x = 0; x < width; x++) {
+      float val = 128.0f + 40.0f * sin(x * 0.02f) * cos(y * 0.015f);
+      for (int32_t i = 0; i < num_blob; i++) {
+        float dx = (x - blob[i * 4]) / blob[i * 4 + 2];
+        float dy = (y - blob[i * 4 + 1]) / blob[i * 4 + 2];
+        float d2 = dx * dx + dy * dy;
+        if (d2 < 4.0f)
+          val += blob[i * 4 + 3] * exp(-d2);
+      }
+      val += noise(rng);
+      img.data[y * width + x] =
+        static_cast<uint8_t>(max(0.0f, min(255.0f, val)));
+    }
+  }
+  return img;
+}
+
+static BenchImage ResizeBenchImage(const BenchImage & src, int32_t width,
+    int32_t height) {
+  BenchImage dest;
+  ostringstream name;
+  name << src.name << "@" << width << "x" << height;
+  dest.name = name.str();
+  dest.width = width;
+  dest.height = height;
+  dest.data.resize(static_cast<size_t>(width) * height);
+
+  seeta::ImageData src_img(src.width, src.height, 1);
+  seeta::ImageData dest_img(width, height, 1);
+  src_img.data = const_cast<uint8_t*>(src.data.data());
+  dest_img.data = dest.data.data();
+  seeta::fd::ImageResizer resizer;
+  resizer.Resize(src_img, &dest_img);
+  return dest;
+}
+
+/** Value at the given fraction of the sorted `values`, by nearest rank */
+static double Percentile(const vector<double> & values, double fraction) {
+  size_t rank = static_cast<size_t>(ceil(fraction * values.size()));
+  return values[rank > 0 ? rank - 1 : 0];
+}
+
+/** Intersection over union of two boxes */
+static float IoU(const seeta::Rect & a, const seeta::Rect & b) {
+  int32_t width = min(a.x + a.width, b.x + b.width) - max(a.x, b.x);
+  int32_t height = min(a.y + a.height, b.y + b.height) - max(a.y, b.y);
+  if (width <= 0 || height <= 0)
+    return 0.0f;
+  float inter = static_cast<float>(width) * height;
+  return inter / (a.width * a.height + b.width * b.height - inter);
+}
+
+/** Number of the faces of `ref` overlapping one of `faces` by half */
+static int64_t CountFound(const vector<seeta::FaceInfo> & ref,
+    const vector<seeta::FaceInfo> & faces) {
+  int64_t num_found = 0;
+  for (size_t i = 0; i < ref.size(); i++) {
+    for (size_t j = 0; j < faces.size(); j++) {
+      if (IoU(ref[i].bbox, faces[j].bbox) >= 0.5f) {
+        num_found++;
+        break;
+      }
+    }
+  }
+  return num_found;
+}
+
+/** Sum of the stats of the runs of one setting */
+typedef struct StatsSum {
+  seeta::DetectionStats sum;
+  int32_t num_run;
+} StatsSum;
+
+static void AddStats(const seeta::DetectionStats & stats, StatsSum* sum) {
+  seeta::DetectionStats & dest = sum->sum;
+  for (size_t i = 0; i < stats.levels.size(); i++) {
+    const seeta::DetectionStats::Level & level = stats.levels[i];
+    dest.levels.resize(max(dest.levels.size(), stats.levels.size()));
+    dest.levels[i].resize_us += level.resize_us;
+    dest.levels[i].feat_map_us += level.feat_map_us;
+    dest.levels[i].scan_us += level.scan_us;
+    dest.levels[i].num_wnd += level.num_wnd;
+    dest.levels[i].num_probe += level.num_probe;
+  }
+  dest.hierarchies.resize(max(dest.hierarchies.size(),
+    stats.hierarchies.size()));
+  for (size_t i = 0; i < stats.hierarchies.size(); i++) {
+    const seeta::DetectionStats::Hierarchy & hierarchy = stats.hierarchies[i];
+    seeta::DetectionStats::Hierarchy & dest_hierarchy = dest.hierarchies[i];
+    dest_hierarchy.num_in += hierarchy.num_in;
+    dest_hierarchy.num_out += hierarchy.num_out;
+    dest_hierarchy.nms_us += hierarchy.nms_us;
+    dest_hierarchy.stage_us.resize(max(dest_hierarchy.stage_us.size(),
+      hierarchy.stage_us.size()), 0);
+    for (size_t j = 0; j < hierarchy.stage_us.size(); j++)
+      dest_hierarchy.stage_us[j] += hierarchy.stage_us[j];
+  }
+  dest.total_us += stats.total_us;
+  dest.num_faces += stats.num_faces;
+  sum->num_run++;
+}
+
+/** Per-call averages of the stats, as a JSON object */
+static string StatsToJSON(const StatsSum & stats_sum) {
+  const seeta::DetectionStats & sum = stats_sum.sum;
+  double n = max(stats_sum.num_run, 1);
+  int64_t resize_us = 0;
+  int64_t feat_map_us = 0;
+  int64_t scan_us = 0;
+  int64_t num_wnd = 0;
+  int64_t num_probe = 0;
+  for (size_t i = 0; i < sum.levels.size(); i++) {
+    resize_us += sum.levels[i].resize_us;
+    feat_map_us += sum.levels[i].feat_map_us;
+    scan_us += sum.levels[i].scan_us;
+    num_wnd += sum.levels[i].num_wnd;
+    num_probe += sum.levels[i].num_probe;
+  }
+
+  ostringstream json;
+  json << "{\"num_levels\": " << sum.levels.size()
+    << ", \"resize_ms\": " << resize_us / n / 1000
+    << ", \"feat_map_ms\": " << feat_map_us / n / 1000
+    << ", \"scan_ms\": " << scan_us / n / 1000
+    << ", \"num_wnd\": " << num_wnd / n
+    << ", \"num_probe\": " << num_probe / n
+    << ", \"hierarchies\": [";
+  for (size_t i = 0; i < sum.hierarchies.size(); i++) {
+    const seeta::DetectionStats::Hierarchy & hierarchy = sum.hierarchies[i];
+    json << (i > 0 ? ", " : "") << "{\"num_in\": " << hierarchy.num_in / n
+      << ", \"num_out\": " << hierarchy.num_out / n << ", \"stage_ms\": [";
+    for (size_t j = 0; j < hierarchy.stage_us.size(); j++)
+      json << (j > 0 ? ", " : "") << hierarchy.stage_us[j] / n / 1000;
+    json << "], \"nms_ms\": " << hierarchy.nms_us / n / 1000 << "}";
+  }
+  json << "]}";
+  return json.str();
+}
+
+/** Escape a string for JSON */
+static string Quote(const string & str) {
+  string quoted = "\"";
+  for (size_t i = 0; i < str.size(); i++) {
+    if (str[i] == '"' || str[i] == '\\')
+      quoted += '\\';
+    quoted += str[i];
+  }
+  return quoted + "\"";
+}
+
+/** One point of the sweep */
+typedef struct BenchSetting {
+  int32_t num_threads;
+  int32_t min_face_size;
+  float scale_factor;
+  int32_t window_step;
+  int32_t coarse_step;
+} BenchSetting;
+
+/** All combinations of the swept values, thread counts outermost */
+static vector<BenchSetting> ListSettings(const BenchOptions & options) {
+  vector<BenchSetting> settings;
+  BenchSetting setting;
+  for (size_t t = 0; t < options.num_threads.size(); t++) {
+    setting.num_threads = options.num_threads[t];
+    for (size_t m = 0; m < options.min_face_sizes.size(); m++) {
+      setting.min_face_size = options.min_face_sizes[m];
+      for (size_t s = 0; s < options.scale_factors.size(); s++) {
+        setting.scale_factor = options.scale_factors[s];
+        for (size_t w = 0; w < options.window_steps.size(); w++) {
+          setting.window_step = options.window_steps[w];
+          for (size_t c = 0; c < options.coarse_steps.size(); c++) {
+            setting.coarse_step = options.coarse_steps[c];
+            settings.push_back(setting);
+          }
+        }
+      }
+    }
+  }
+  return settings;
+}
+
+/**
+ * Benchmark `detector` on `imgs` with one setting, and return the results as
+ * a JSON object. Latency is that of serial `Detect()` calls; batch
+ * throughput is that of `DetectBatch()` on all the images at once, which
+ * spreads the work of several images over the threads.
+ */
+static string RunSetting(const BenchOptions & options,
+    const BenchSetting & setting, const vector<BenchImage> & imgs,
+    seeta::FaceDetection* detector) {
+  detector->SetNumThreads(setting.num_threads);
+  detector->SetMinFaceSize(setting.min_face_size);
+  detector->SetImagePyramidScaleFactor(setting.scale_factor);
+  detector->SetWindowStep(setting.window_step, setting.window_step);
+
+  vector<seeta::ImageData> img_data(imgs.size());
+  for (size_t i = 0; i < imgs.size(); i++) {
+    img_data[i] = seeta::ImageData(imgs[i].width, imgs[i].height, 1);
+    img_data[i].data = const_cast<uint8_t*>(imgs[i].data.data());
+  }
+
+  // Faces of the exhaustive scan, against which the recall of the
+  // coarse-to-fine search is measured
+  vector<vector<seeta::FaceInfo> > ref_faces(img_data.size());
+  int64_t num_ref = 0;
+  detector->SetCoarseWindowStep(0);
+  for (size_t i = 0; i < img_data.size(); i++) {
+    ref_faces[i] = detector->Detect(img_data[i]);
+    num_ref += ref_faces[i].size();
+  }
+  detector->SetCoarseWindowStep(setting.coarse_step);
+
+  for (int32_t k = 0; k < options.num_warmup; k++) {
+    for (size_t i = 0; i < img_data.size(); i++)
+      detector->Detect(img_data[i]);
+    detector->DetectBatch(img_data);
+  }
+
+  // Latencies are measured without stats, which are gathered by one more
+  // run of each image
+  vector<double> latency_ms;
+  int64_t num_faces = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int32_t k = 0; k < options.num_iter; k++) {
+    for (size_t i = 0; i < img_data.size(); i++) {
+      auto call_start = std::chrono::steady_clock::now();
+      num_faces += detector->Detect(img_data[i]).size();
+      auto call_end = std::chrono::steady_clock::now();
+      latency_ms.push_back(std::chrono::duration<double, std::milli>(
+        call_end - call_start).count());
+    }
+  }
+  double total_s = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+
+  start = std::chrono::steady_clock::now();
+  for (int32_t k = 0; k < options.num_iter; k++)
+    detector->DetectBatch(img_data);
+  double batch_s = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+
+  StatsSum stats_sum;
+  stats_sum.num_run = 0;
+  int64_t num_found = 0;
+  for (size_t i = 0; i < img_data.size(); i++) {
+    seeta::DetectionStats stats;
+    num_found += CountFound(ref_faces[i],
+      detector->Detect(img_data[i], &stats));
+    AddStats(stats, &stats_sum);
+  }
+
+  double mean_ms = 0;
+  for (size_t i = 0; i < latency_ms.size(); i++)
+    mean_ms += latency_ms[i];
+  mean_ms /= latency_ms.size();
+  std::sort(latency_ms.begin(), latency_ms.end());
+
+  ostringstream json;
+  json << "{\"width\": " << imgs[0].width
+    << ", \"height\": " << imgs[0].height
+    << ", \"num_images\": " << imgs.size()
+    << ", \"threads\": " << setting.num_threads
+    << ", \"min_face_size\": " << setting.min_face_size
+    << ", \"scale_factor\": " << setting.scale_factor
+    << ", \"window_step\": " << setting.window_step
+    << ", \"coarse_step\": " << setting.coarse_step
+    << ", \"iterations\": " << options.num_iter
+    << ", \"throughput_fps\": " << latency_ms.size() / total_s
+    << ", \"batch_throughput_fps\": "
+    << options.num_iter * img_data.size() / batch_s
+    << ", \"latency_ms\": {\"mean\": " << mean_ms
+    << ", \"p50\": " << Percentile(latency_ms, 0.5)
+    << ", \"p99\": " << Percentile(latency_ms, 0.99)
+    << ", \"min\": " << latency_ms.front()
+    << ", \"max\": " << latency_ms.back() << "}"
+    << ", \"faces_per_image\": "
+    << static_cast<double>(num_faces) / latency_ms.size()
+    << ", \"recall\": " << (num_ref > 0 ?
+      static_cast<double>(num_found) / num_ref : 1.0)
+    << ", \"stages\": " << StatsToJSON(stats_sum) << "}";
+  return json.str();
+}
+
+int main(int argc, char** argv) {
+  BenchOptions options;
+  if (!ParseOptions(argc, argv, &options)) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  // Group the images by size, each group being benchmarked on its own
+  vector<vector<BenchImage> > groups;
+  if (options.image_paths.empty()) {
+    if (options.sizes.empty()) {
+      options.sizes.push_back(make_pair(640, 480));
+      options.sizes.push_back(make_pair(1280, 720));
+      options.sizes.push_back(make_pair(1920, 1080));
+    }
+    for (size_t i = 0; i < options.sizes.size(); i++) {
+      groups.push_back(vector<BenchImage>());
+      for (uint32_t seed = 0; seed < 4; seed++) {
+        groups.back().push_back(GenerateImage(options.sizes[i].first,
+          options.sizes[i].second, 2016 + seed));
+      }
+    }
+  } else {
+    vector<BenchImage> imgs(options.image_paths.size());
+    for (size_t i = 0; i < imgs.size(); i++) {
+      if (!ReadImage(options.image_paths[i], &imgs[i])) {
+        cerr << "Failed to read " << options.image_paths[i] << endl;
+        return 1;
+      }
+    }
+    if (options.sizes.empty()) {
+      groups.push_back(imgs);
+    } else {
+      for (size_t i = 0; i < options.sizes.size(); i++) {
+        groups.push_back(vector<BenchImage>());
+        for (size_t j = 0; j < imgs.size(); j++) {
+          groups.back().push_back(ResizeBenchImage(imgs[j],
+            options.sizes[i].first, options.sizes[i].second));
+        }
+      }
+    }
+  }
+
+  seeta::FaceDetection detector(options.model_path.c_str());
+  detector.SetScoreThresh(2.f);
+  detector.SetTileMemoryLimit(options.tile_memory);
+
+  cout << "{\"model\": " << Quote(options.model_path)
+    << ", \"cpu_isa\": " << Quote(seeta::fd::GetSIMDKernels().isa)
+    << ", \"tile_memory\": " << options.tile_memory
+    << ", \"results\": [";
+  vector<BenchSetting> settings = ListSettings(options);
+  bool is_first = true;
+  for (size_t g = 0; g < groups.size(); g++) {
+    for (size_t i = 0; i < settings.size(); i++) {
+      cout << (is_first ? "\n" : ",\n") << "  "
+        << RunSetting(options, settings[i], groups[g], &detector);
+      is_first = false;
+    }
+  }
+  cout << "\n]}" << endl;
+
+  return 0;
+}
@@ -79,20 +79,21 @@ int main(int argc, char** argv) {
 	// IMREAD_LOAD_GDALʹGDALȡļGDALGeospatial Data Abstraction LibraryX/MITЭµĿԴդռת⡣
 	//                   óģֵ֧ĸļʽһϵйתʹ
   cv::Mat img = cv::imread(img_path, cv::IMREAD_UNCHANGED);
-  cv::Mat img_gray;			// Ҷͼ
+  cv::Mat img_input;			// gray or BGR, both read by the detector in place
 
-  if (img.channels() != 1)		// ͨ1Ҫͨ cv::cvtColor() ת
-	  cv::cvtColor(img, img_gray, cv::COLOR_BGR2GRAY);
-  else                            // ͨΪ1ͼǻҶͼֱӸֵ 
-	  img_gray = img;
+  if (img.channels() == 4)
+	  cv::cvtColor(img, img_input, cv::COLOR_BGRA2BGR);
+  else
+	  img_input = img;
+  if (img_input.channels() == 3)	// BGR is converted to gray by the detector
+	  detector.SetImageFormat(seeta::kImageBGR);
 
   seeta::ImageData img_data;
-  img_data.data = img_gray.data;		// Ҷͼݸֵ
-  img_data.width = img_gray.cols;		// ҶͼΪͼĿ
-  img_data.height = img_gray.rows;	// ҶͼΪͼĸ߶
-  img_data.num_channels = 1;			// Ҷͼ̶ͨΪ1
-
-  cv::imshow("Ҷͼ", img_gray);
+  img_data.data = img_input.data;
+  img_data.width = img_input.cols;
+  img_data.height = img_input.rows;
+  img_data.num_channels = img_input.channels();
+  img_data.stride = static_cast<int32_t>(img_input.step);  // rows may be padded
 
   long t0 = cv::getTickCount();
 
@@ -103,12 +104,6 @@ int main(int argc, char** argv) {
   double secs = (t1 - t0)/cv::getTickFrequency();
 
   cout << "Detections takes " << secs << " seconds " << endl;
-#ifdef USE_OPENMP
-  cout << "OpenMP is used." << endl;
-#else
-  cout << "OpenMP is not used. " << endl;
-#endif
-
 #ifdef USE_SSE
   cout << "SSE is used." << endl;
 #else
@@ -0,0 +1,140 @@
+/*
+ *
+ * This file is part of the open-source SeetaFace engine, which includes three modules:
+ * SeetaFace Detection, SeetaFace Alignment, and SeetaFace Identification.
+ *
+ * This file is part of the SeetaFace Detection module, containing codes implementing the
+ * face detection method described in the following paper:
+ *
+ *
+ *   Funnel-structured cascade for multi-view face detection with alignment awareness,
+ *   Shuzhe Wu, Meina Kan, Zhenliang He, Shiguang Shan, Xilin Chen.
+ *   In Neurocomputing (under review)
+ *
+ *
+ * Copyright (C) 2016, Visual Information Processing and Learning (VIPL) group,
+ * Institute of Computing Technology, Chinese Academy of Sciences, Beijing, China.
+ *
+ * The codes are mainly developed by Shuzhe Wu (a Ph.D supervised by Prof. Shiguang Shan)
+ *
+ * As an open-source face recognition engine: you can redistribute SeetaFace source codes
+ * and/or modify it under the terms of the BSD 2-Clause License.
+ *
+ * You should have received a copy of the BSD 2-Clause License along with the software.
+ * If not, see < https://opensource.org/licenses/BSD-2-Clause>.
+ *
+ * Contact Info: you can send an email to SeetaFace@vipl.ict.ac.cn for any problems.
+ *
+ * Note: the above information must be kept whenever or wherever the codes are used.
+ *
+ */
+
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "common.h"
+#include "util/nms.h"
+
+using namespace std;
+
+typedef void (*NMSFunc)(std::vector<seeta::FaceInfo>*,
+  std::vector<seeta::FaceInfo>*, float);
+
+/**
+ * Proposals as given by the sliding window: clusters of boxes around faces
+ * of various sizes, plus scattered false alarms.
+ */
+static vector<seeta::FaceInfo> GenerateProposals(int32_t num_bbox,
+    int32_t img_width, int32_t img_height, std::mt19937* rng) {
+  std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+  std::normal_distribution<float> jitter(0.0f, 0.05f);
+  vector<seeta::FaceInfo> faces(num_bbox / 20 + 1);
+  for (size_t i = 0; i < faces.size(); i++) {
+    int32_t size = static_cast<int32_t>(20 + 200 * uniform(*rng) * uniform(*rng));
+    faces[i].bbox.width = faces[i].bbox.height = size;
+    faces[i].bbox.x = static_cast<int32_t>((img_width - size) * uniform(*rng));
+    faces[i].bbox.y = static_cast<int32_t>((img_height - size) * uniform(*rng));
+  }
+
+  vector<seeta::FaceInfo> bboxes(num_bbox);
+  for (int32_t i = 0; i < num_bbox; i++) {
+    seeta::FaceInfo & bbox = bboxes[i];
+    if (i % 4 == 3) {
+      int32_t size = static_cast<int32_t>(20 + 300 * uniform(*rng) * uniform(*rng));
+      bbox.bbox.width = bbox.bbox.height = size;
+      bbox.bbox.x = static_cast<int32_t>((img_width - size) * uniform(*rng));
+      bbox.bbox.y = static_cast<int32_t>((img_height - size) * uniform(*rng));
+    } else {
+      const seeta::Rect & face = faces[i % faces.size()].bbox;
+      bbox.bbox.width = bbox.bbox.height =
+        static_cast<int32_t>(face.width * (1 + jitter(*rng)));
+      bbox.bbox.x = face.x + static_cast<int32_t>(face.width * jitter(*rng));
+      bbox.bbox.y = face.y + static_cast<int32_t>(face.width * jitter(*rng));
+    }
+    bbox.score = uniform(*rng);
+  }
+  return bboxes;
+}
+
+/** Best time in milliseconds of a few runs, and the result of the last one */
+static double Time(NMSFunc nms, const vector<seeta::FaceInfo> & bboxes,
+    float iou_thresh, vector<seeta::FaceInfo>* bboxes_nms) {
+  double best = 0;
+  for (int32_t i = 0; i < 5; i++) {
+    vector<seeta::FaceInfo> input = bboxes;
+    auto start = std::chrono::steady_clock::now();
+    nms(&input, bboxes_nms, iou_thresh);
+    auto end = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    if (i == 0 || ms < best)
+      best = ms;
+  }
+  return best;
+}
+
+static bool IsSame(const vector<seeta::FaceInfo> & a,
+    const vector<seeta::FaceInfo> & b) {
+  if (a.size() != b.size())
+    return false;
+  for (size_t i = 0; i < a.size(); i++) {
+    if (a[i].bbox.x != b[i].bbox.x || a[i].bbox.y != b[i].bbox.y ||
+        a[i].bbox.width != b[i].bbox.width ||
+        a[i].bbox.height != b[i].bbox.height ||
+        std::memcmp(&a[i].score, &b[i].score, sizeof(double)) != 0)
+      return false;
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  const int32_t num_bbox[] = { 100, 1000, 5000, 20000 };
+  const float iou_thresh[] = { 0.8f, 0.3f };
+  std::mt19937 rng(2016);
+  bool all_same = true;
+
+  cout << "num_bbox\tiou_thresh\tpairwise_ms\tbucketed_ms\tspeedup\tsame" << endl;
+  for (int32_t i = 0; i < 4; i++) {
+    vector<seeta::FaceInfo> bboxes =
+      GenerateProposals(num_bbox[i], 1920, 1080, &rng);
+    for (int32_t j = 0; j < 2; j++) {
+      vector<seeta::FaceInfo> result_pairwise;
+      vector<seeta::FaceInfo> result_bucketed;
+      double ms_pairwise = Time(seeta::fd::NonMaximumSuppressionPairwise,
+        bboxes, iou_thresh[j], &result_pairwise);
+      double ms_bucketed = Time(seeta::fd::NonMaximumSuppression,
+        bboxes, iou_thresh[j], &result_bucketed);
+      bool same = IsSame(result_pairwise, result_bucketed);
+      all_same = all_same && same;
+      cout << num_bbox[i] << "\t" << iou_thresh[j] << "\t" << ms_pairwise
+        << "\t" << ms_bucketed << "\t" << ms_pairwise / ms_bucketed << "\t"
+        << (same ? "yes" : "NO") << endl;
+    }
+  }
+
+  return (all_same ? 0 : 1);
+}
@@ -0,0 +1,120 @@
+/*
+ *
+ * This file is part of the open-source SeetaFace engine, which includes three modules:
+ * SeetaFace Detection, SeetaFace Alignment, and SeetaFace Identification.
+ *
+ * This file is part of the SeetaFace Detection module, containing codes implementing the
+ * face detection method described in the following paper:
+ *
+ *
+ *   Funnel-structured cascade for multi-view face detection with alignment awareness,
+ *   Shuzhe Wu, Meina Kan, Zhenliang He, Shiguang Shan, Xilin Chen.
+ *   In Neurocomputing (under review)
+ *
+ *
+ * Copyright (C) 2016, Visual Information Processing and Learning (VIPL) group,
+ * Institute of Computing Technology, Chinese Academy of Sciences, Beijing, China.
+ *
+ * The codes are mainly developed by Shuzhe Wu (a Ph.D supervised by Prof. Shiguang Shan)
+ *
+ * As an open-source face recognition engine: you can redistribute SeetaFace source codes
+ * and/or modify it under the terms of the BSD 2-Clause License.
+ *
+ * You should have received a copy of the BSD 2-Clause License along with the software.
+ * If not, see < https://opensource.org/licenses/BSD-2-Clause>.
+ *
+ * Contact Info: you can send an email to SeetaFace@vipl.ict.ac.cn for any problems.
+ *
+ * Note: the above information must be kept whenever or wherever the codes are used.
+ *
+ */
+
+
+
+#include "util/color_converter.h"
+
+#ifdef USE_SSE
+#include <immintrin.h>
+#endif
+
+#include <cstring>
+
+namespace seeta {
+namespace fd {
+
+void ConvertRowToGray(const uint8_t* src, int32_t len, int32_t num_channels,
+    ChannelOrder order, uint8_t* dest) {
+  if (num_channels == 1) {
+    std::memcpy(dest, src, len * sizeof(uint8_t));
+    return;
+  }
+
+  const int32_t w0 = (order == kChannelBGR ? 29 : 77);
+  const int32_t w1 = 150;
+  const int32_t w2 = (order == kChannelBGR ? 77 : 29);
+  int32_t i = 0;
+
+#ifdef USE_SSE
+  // Gather each channel of 16 pixels from three loads, in which pixel k has
+  // its channel c at byte 3k + c
+  const __m128i c0a = _mm_setr_epi8(0, 3, 6, 9, 12, 15,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m128i c0b = _mm_setr_epi8(-1, -1, -1, -1, -1, -1,
+    2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+  const __m128i c0c = _mm_setr_epi8(-1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+  const __m128i c1a = _mm_setr_epi8(1, 4, 7, 10, 13,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m128i c1b = _mm_setr_epi8(-1, -1, -1, -1, -1,
+    0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+  const __m128i c1c = _mm_setr_epi8(-1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+  const __m128i c2a = _mm_setr_epi8(2, 5, 8, 11, 14,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m128i c2b = _mm_setr_epi8(-1, -1, -1, -1, -1,
+    1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+  const __m128i c2c = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    0, 3, 6, 9, 12, 15);
+  const __m128i wt0 = _mm_set1_epi16(static_cast<int16_t>(w0));
+  const __m128i wt1 = _mm_set1_epi16(static_cast<int16_t>(w1));
+  const __m128i wt2 = _mm_set1_epi16(static_cast<int16_t>(w2));
+  const __m128i half = _mm_set1_epi16(128);
+  const __m128i zero = _mm_setzero_si128();
+
+  for (; i + 16 <= len; i += 16) {
+    const uint8_t* p = src + i * 3;
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16));
+    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 32));
+    __m128i ch0 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, c0a),
+      _mm_shuffle_epi8(b, c0b)), _mm_shuffle_epi8(c, c0c));
+    __m128i ch1 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, c1a),
+      _mm_shuffle_epi8(b, c1b)), _mm_shuffle_epi8(c, c1c));
+    __m128i ch2 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, c2a),
+      _mm_shuffle_epi8(b, c2b)), _mm_shuffle_epi8(c, c2c));
+
+    // The weighted sums stay below 2^16, so unsigned 16-bit lanes suffice
+    __m128i lo = _mm_add_epi16(_mm_add_epi16(
+      _mm_mullo_epi16(_mm_unpacklo_epi8(ch0, zero), wt0),
+      _mm_mullo_epi16(_mm_unpacklo_epi8(ch1, zero), wt1)),
+      _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(ch2, zero), wt2),
+      half));
+    __m128i hi = _mm_add_epi16(_mm_add_epi16(
+      _mm_mullo_epi16(_mm_unpackhi_epi8(ch0, zero), wt0),
+      _mm_mullo_epi16(_mm_unpackhi_epi8(ch1, zero), wt1)),
+      _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(ch2, zero), wt2),
+      half));
+    __m128i gray = _mm_packus_epi16(_mm_srli_epi16(lo, 8),
+      _mm_srli_epi16(hi, 8));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), gray);
+  }
+#endif
+  for (; i < len; i++) {
+    const uint8_t* p = src + i * num_channels;
+    dest[i] = static_cast<uint8_t>((w0 * p[0] + w1 * p[1] + w2 * p[2] + 128)
+      >> 8);
+  }
+}
+
+}  // namespace fd
+}  // namespace seeta
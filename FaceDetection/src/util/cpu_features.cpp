@@ -0,0 +1,125 @@
+/*
+ *
+ * This file is part of the open-source SeetaFace engine, which includes three modules:
+ * SeetaFace Detection, SeetaFace Alignment, and SeetaFace Identification.
+ *
+ * This file is part of the SeetaFace Detection module, containing codes implementing the
+ * face detection method described in the following paper:
+ *
+ *
+ *   Funnel-structured cascade for multi-view face detection with alignment awareness,
+ *   Shuzhe Wu, Meina Kan, Zhenliang He, Shiguang Shan, Xilin Chen.
+ *   In Neurocomputing (under review)
+ *
+ *
+ * Copyright (C) 2016, Visual Information Processing and Learning (VIPL) group,
+ * Institute of Computing Technology, Chinese Academy of Sciences, Beijing, China.
+ *
+ * The codes are mainly developed by Shuzhe Wu (a Ph.D supervised by Prof. Shiguang Shan)
+ *
+ * As an open-source face recognition engine: you can redistribute SeetaFace source codes
+ * and/or modify it under the terms of the BSD 2-Clause License.
+ *
+ * You should have received a copy of the BSD 2-Clause License along with the software.
+ * If not, see < https://opensource.org/licenses/BSD-2-Clause>.
+ *
+ * Contact Info: you can send an email to SeetaFace@vipl.ict.ac.cn for any problems.
+ *
+ * Note: the above information must be kept whenever or wherever the codes are used.
+ *
+ */
+
+
+
+#include "util/cpu_features.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || \
+    defined(_M_IX86)
+#define SEETA_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace seeta {
+namespace fd {
+
+#ifdef SEETA_X86
+/** Registers EAX, EBX, ECX and EDX of CPUID `leaf`, `subleaf` */
+static void CPUID(uint32_t leaf, uint32_t subleaf, uint32_t* regs) {
+#ifdef _MSC_VER
+  int32_t info[4];
+  __cpuidex(reinterpret_cast<int*>(info), leaf, subleaf);
+  for (int32_t i = 0; i < 4; i++)
+    regs[i] = static_cast<uint32_t>(info[i]);
+#else
+  if (!__get_cpuid_count(leaf, subleaf, &regs[0], &regs[1], &regs[2],
+      &regs[3]))
+    regs[0] = regs[1] = regs[2] = regs[3] = 0;
+#endif
+}
+
+/** Register states enabled by the OS, i.e. XCR0 */
+static uint64_t GetXCR0() {
+#ifdef _MSC_VER
+  return _xgetbv(0);
+#else
+  uint32_t eax;
+  uint32_t edx;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+#endif
+
+static CPUFeatures DetectCPUFeatures() {
+  CPUFeatures features;
+  std::memset(&features, 0, sizeof(features));
+
+#ifdef SEETA_X86
+  uint32_t regs[4];
+  CPUID(0, 0, regs);
+  uint32_t max_leaf = regs[0];
+  if (max_leaf < 1)
+    return features;
+
+  CPUID(1, 0, regs);
+  bool has_xsave = (regs[2] & (1u << 27)) != 0;
+  bool has_avx = (regs[2] & (1u << 28)) != 0;
+  if (!has_xsave || !has_avx || max_leaf < 7)
+    return features;
+
+  // XMM and YMM states, then opmask and ZMM states
+  uint64_t xcr0 = GetXCR0();
+  bool os_avx = (xcr0 & 0x6) == 0x6;
+  bool os_avx512 = os_avx && (xcr0 & 0xE0) == 0xE0;
+
+  CPUID(7, 0, regs);
+  features.avx2 = os_avx && (regs[1] & (1u << 5)) != 0;
+  features.avx512f = os_avx512 && (regs[1] & (1u << 16)) != 0;
+#endif
+
+  const char* max_isa = std::getenv("SEETA_CPU_MAX_ISA");
+  if (max_isa != nullptr) {
+    if (std::strcmp(max_isa, "avx512") != 0)
+      features.avx512f = false;
+    if (std::strcmp(max_isa, "avx512") != 0 &&
+        std::strcmp(max_isa, "avx2") != 0)
+      features.avx2 = false;
+  }
+  return features;
+}
+
+const CPUFeatures & GetCPUFeatures() {
+  static const CPUFeatures features = DetectCPUFeatures();
+  return features;
+}
+
+}  // namespace fd
+}  // namespace seeta
@@ -0,0 +1,103 @@
+/*
+ *
+ * This file is part of the open-source SeetaFace engine, which includes three modules:
+ * SeetaFace Detection, SeetaFace Alignment, and SeetaFace Identification.
+ *
+ * This file is part of the SeetaFace Detection module, containing codes implementing the
+ * face detection method described in the following paper:
+ *
+ *
+ *   Funnel-structured cascade for multi-view face detection with alignment awareness,
+ *   Shuzhe Wu, Meina Kan, Zhenliang He, Shiguang Shan, Xilin Chen.
+ *   In Neurocomputing (under review)
+ *
+ *
+ * Copyright (C) 2016, Visual Information Processing and Learning (VIPL) group,
+ * Institute of Computing Technology, Chinese Academy of Sciences, Beijing, China.
+ *
+ * The codes are mainly developed by Shuzhe Wu (a Ph.D supervised by Prof. Shiguang Shan)
+ *
+ * As an open-source face recognition engine: you can redistribute SeetaFace source codes
+ * and/or modify it under the terms of the BSD 2-Clause License.
+ *
+ * You should have received a copy of the BSD 2-Clause License along with the software.
+ * If not, see < https://opensource.org/licenses/BSD-2-Clause>.
+ *
+ * Contact Info: you can send an email to SeetaFace@vipl.ict.ac.cn for any problems.
+ *
+ * Note: the above information must be kept whenever or wherever the codes are used.
+ *
+ */
+
+
+#include "util/detection_mask.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace seeta {
+namespace fd {
+
+void DetectionMask::SetRects(int32_t width, int32_t height,
+    const std::vector<seeta::Rect> & rois) {
+  width_ = mask_width_ = width;
+  height_ = mask_height_ = height;
+  cell_size_ = 1;
+  mask_.assign(width * height, 0);
+
+  for (size_t i = 0; i < rois.size(); i++) {
+    int32_t x1 = std::max(rois[i].x, 0);
+    int32_t y1 = std::max(rois[i].y, 0);
+    int32_t x2 = std::min(rois[i].x + rois[i].width, width);
+    int32_t y2 = std::min(rois[i].y + rois[i].height, height);
+    for (int32_t y = y1; y < y2; y++)
+      std::memset(mask_.data() + y * width + x1, 1, std::max(x2 - x1, 0));
+  }
+  UpdateBBox();
+}
+
+void DetectionMask::SetMask(int32_t width, int32_t height,
+    const uint8_t* mask, int32_t cell_size) {
+  width_ = width;
+  height_ = height;
+  cell_size_ = cell_size;
+  mask_width_ = (width + cell_size - 1) / cell_size;
+  mask_height_ = (height + cell_size - 1) / cell_size;
+  mask_.assign(mask, mask + mask_width_ * mask_height_);
+  UpdateBBox();
+}
+
+void DetectionMask::UpdateBBox() {
+  int32_t x1 = mask_width_;
+  int32_t y1 = mask_height_;
+  int32_t x2 = -1;
+  int32_t y2 = -1;
+
+  for (int32_t y = 0; y < mask_height_; y++) {
+    const uint8_t* row = mask_.data() + y * mask_width_;
+    int32_t x = 0;
+    while (x < mask_width_ && row[x] == 0)
+      x++;
+    if (x == mask_width_)
+      continue;
+    x1 = std::min(x1, x);
+    x = mask_width_ - 1;
+    while (row[x] == 0)
+      x--;
+    x2 = std::max(x2, x);
+    y1 = std::min(y1, y);
+    y2 = y;
+  }
+
+  if (x2 < 0) {
+    bbox_.x = bbox_.y = bbox_.width = bbox_.height = 0;
+  } else {
+    bbox_.x = x1 * cell_size_;
+    bbox_.y = y1 * cell_size_;
+    bbox_.width = std::min((x2 + 1) * cell_size_, width_) - bbox_.x;
+    bbox_.height = std::min((y2 + 1) * cell_size_, height_) - bbox_.y;
+  }
+}
+
+}  // namespace fd
+}  // namespace seeta
@@ -34,65 +34,94 @@
 namespace seeta {
 namespace fd {
 
-const seeta::ImageData* ImagePyramid::GetNextScaleImage(float* scale_factor) {
-  if (scale_factor_ >= min_scale_) {
-    if (scale_factor != nullptr)
-      *scale_factor = scale_factor_;
+int32_t ImagePyramid::GetNumScales() const {
+  int32_t num_scales = 0;
+  for (float scale = max_scale_; scale >= min_scale_; scale *= scale_step_)
+    num_scales++;
+  return num_scales;
+}
+
+float ImagePyramid::GetScale(int32_t level) const {
+  float scale = max_scale_;
+  for (int32_t i = 0; i < level; i++)
+    scale *= scale_step_;
+  return scale;
+}
 
-    width_scaled_ = static_cast<int32_t>(width1x_ * scale_factor_);
-    height_scaled_ = static_cast<int32_t>(height1x_ * scale_factor_);
+void ImagePyramid::GetScaleSize(int32_t level, int32_t* width,
+    int32_t* height) const {
+  float scale = GetScale(level);
+  *width = static_cast<int32_t>(width1x_ * scale);
+  *height = static_cast<int32_t>(height1x_ * scale);
+}
+
+void ImagePyramid::BuildScaleImages() {
+  if (is_built_)
+    return;
 
-    seeta::ImageData src_img(width1x_, height1x_);
-    seeta::ImageData dest_img(width_scaled_, height_scaled_);
-    src_img.data = buf_img_;
-    dest_img.data = buf_img_scaled_;
-    seeta::fd::ResizeImage(src_img, &dest_img);
-    scale_factor_ *= scale_step_;
+  int32_t num_scales = GetNumScales();
+  std::vector<size_t> offset(num_scales);
+  size_t len = 0;
 
-    img_scaled_.data = buf_img_scaled_;
-    img_scaled_.width = width_scaled_;
-    img_scaled_.height = height_scaled_;
-    return &img_scaled_;
-  } else {
-    return nullptr;
+  img_scaled_.resize(num_scales);
+  for (int32_t i = 0; i < num_scales; i++) {
+    GetScaleSize(i, &(img_scaled_[i].width), &(img_scaled_[i].height));
+    offset[i] = len;
+    len += static_cast<size_t>(img_scaled_[i].width) * img_scaled_[i].height;
   }
-}
+  buf_img_scaled_.resize(len);
 
-void ImagePyramid::SetImage1x(const uint8_t* img_data, int32_t width,
-    int32_t height) {
-  if (width > buf_img_width_ || height > buf_img_height_) {
-    delete[] buf_img_;
+  seeta::ImageData src_img = image1x();
+  for (int32_t i = 0; i < num_scales; i++) {
+    int64_t start = (stats_recorder_ != nullptr ?
+      stats_recorder_->GetElapsed() : 0);
+    img_scaled_[i].data = buf_img_scaled_.data() + offset[i];
+    img_scaled_[i].num_channels = 1;
+    resizer_.Resize(src_img, &(img_scaled_[i]), channel_order_);
+    src_img = img_scaled_[i];
 
-    buf_img_width_ = width;
-    buf_img_height_ = height;
-    buf_img_ = new uint8_t[width * height];
+    if (stats_recorder_ != nullptr) {
+      seeta::DetectionStats::Level level_stats;
+      level_stats.scale = GetScale(i);
+      level_stats.width = img_scaled_[i].width;
+      level_stats.height = img_scaled_[i].height;
+      level_stats.resize_us = stats_recorder_->GetElapsed() - start;
+      stats_recorder_->AddLevel(i, level_stats);
+    }
   }
 
-  width1x_ = width;
-  height1x_ = height;
-  std::memcpy(buf_img_, img_data, width * height * sizeof(uint8_t));
-  scale_factor_ = max_scale_;
-  UpdateBufScaled();
+  is_built_ = true;
 }
 
-void ImagePyramid::UpdateBufScaled() {
-  if (width1x_ == 0 || height1x_ == 0)
+void ImagePyramid::GetScaleRegion(int32_t level, const seeta::Rect & rect,
+    seeta::fd::ImageResizer* resizer, seeta::ImageData* dest) const {
+  if (is_built_) {
+    const seeta::ImageData & img_scaled = img_scaled_[level];
+    for (int32_t y = 0; y < rect.height; y++) {
+      std::memcpy(dest->data + y * dest->GetStride(), img_scaled.data +
+        (rect.y + y) * img_scaled.width + rect.x, rect.width * sizeof(uint8_t));
+    }
     return;
+  }
 
-  int32_t max_width = static_cast<int32_t>(width1x_ * max_scale_ + 0.5);
-  int32_t max_height = static_cast<int32_t>(height1x_ * max_scale_ + 0.5);
-
-  if (max_width > buf_scaled_width_ || max_height > buf_scaled_height_) {
-    delete[] buf_img_scaled_;
-
-    buf_scaled_width_ = max_width;
-    buf_scaled_height_ = max_height;
-    buf_img_scaled_ = new uint8_t[max_width * max_height];
+  int32_t width;
+  int32_t height;
+  GetScaleSize(level, &width, &height);
+  resizer->ResizeRegion(image1x(), width, height, rect, dest, channel_order_);
+}
 
-    img_scaled_.data = nullptr;
-    img_scaled_.width = 0;
-    img_scaled_.height = 0;
-  }
+void ImagePyramid::SetImage1x(const seeta::ImageData & img,
+    ChannelOrder order) {
+  width1x_ = img.width;
+  height1x_ = img.height;
+  img1x_data_ = img.data;
+  img1x_stride_ = img.GetStride();
+  img1x_channels_ = img.num_channels;
+  channel_order_ = order;
+  is_built_ = false;
+  mask_ = nullptr;
+  time_budget_ = nullptr;
+  stats_recorder_ = nullptr;
 }
 
 }  // namespace fd
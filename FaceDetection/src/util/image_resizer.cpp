@@ -0,0 +1,148 @@
+/*
+ *
+ * This file is part of the open-source SeetaFace engine, which includes three modules:
+ * SeetaFace Detection, SeetaFace Alignment, and SeetaFace Identification.
+ *
+ * This file is part of the SeetaFace Detection module, containing codes implementing the
+ * face detection method described in the following paper:
+ *
+ *
+ *   Funnel-structured cascade for multi-view face detection with alignment awareness,
+ *   Shuzhe Wu, Meina Kan, Zhenliang He, Shiguang Shan, Xilin Chen.
+ *   In Neurocomputing (under review)
+ *
+ *
+ * Copyright (C) 2016, Visual Information Processing and Learning (VIPL) group,
+ * Institute of Computing Technology, Chinese Academy of Sciences, Beijing, China.
+ *
+ * The codes are mainly developed by Shuzhe Wu (a Ph.D supervised by Prof. Shiguang Shan)
+ *
+ * As an open-source face recognition engine: you can redistribute SeetaFace source codes
+ * and/or modify it under the terms of the BSD 2-Clause License.
+ *
+ * You should have received a copy of the BSD 2-Clause License along with the software.
+ * If not, see < https://opensource.org/licenses/BSD-2-Clause>.
+ *
+ * Contact Info: you can send an email to SeetaFace@vipl.ict.ac.cn for any problems.
+ *
+ * Note: the above information must be kept whenever or wherever the codes are used.
+ *
+ */
+
+
+#include "util/image_resizer.h"
+
+#include <algorithm>
+
+namespace seeta {
+namespace fd {
+
+void ImageResizer::Resize(const seeta::ImageData & src,
+    seeta::ImageData* dest, ChannelOrder order) {
+  seeta::Rect rect;
+  rect.x = rect.y = 0;
+  rect.width = dest->width;
+  rect.height = dest->height;
+  ResizeRegion(src, dest->width, dest->height, rect, dest, order);
+}
+
+void ImageResizer::ResizeRegion(const seeta::ImageData & src,
+    int32_t dest_width, int32_t dest_height, const seeta::Rect & rect,
+    seeta::ImageData* dest, ChannelOrder order) {
+  int32_t src_width = src.width;
+  int32_t src_height = src.height;
+  int32_t src_stride = src.GetStride();
+  int32_t num_channels = src.num_channels;
+  int32_t dest_stride = dest->GetStride();
+
+  if (rect.width <= 0 || rect.height <= 0)
+    return;
+  if (src_width == dest_width && src_height == dest_height) {
+    for (int32_t y = 0; y < rect.height; y++) {
+      ConvertRowToGray(src.data + (rect.y + y) * src_stride +
+        rect.x * num_channels, rect.width, num_channels, order,
+        dest->data + y * dest_stride);
+    }
+    return;
+  }
+  ComputeTable(src_width, dest_width, rect.x, rect.width, &x_offset_,
+    &x_weight_);
+  ComputeTable(src_height, dest_height, rect.y, rect.height, &y_offset_,
+    &y_weight_);
+  row_buf_[0].resize(rect.width);
+  row_buf_[1].resize(rect.width);
+  if (num_channels != 1 || src_width < 2)
+    gray_row_.resize(std::max(src_width, 2));
+
+  const seeta::fd::SIMDKernels & kernels = seeta::fd::GetSIMDKernels();
+  // Source rows held by `row_buf_`, reused by consecutive destination rows
+  int32_t buf_row[2] = { -1, -1 };
+
+  for (int32_t y = 0; y < rect.height; y++) {
+    int32_t src_y = y_offset_[y];
+    if (buf_row[0] != src_y) {
+      if (buf_row[1] == src_y) {
+        row_buf_[0].swap(row_buf_[1]);
+        buf_row[0] = src_y;
+        buf_row[1] = -1;
+      } else {
+        InterpolateRow(GetGrayRow(src, src_y, order), src_width,
+          row_buf_[0].data());
+        buf_row[0] = src_y;
+      }
+    }
+    if (buf_row[1] != src_y + 1) {
+      // A single source row is blended with itself
+      InterpolateRow(GetGrayRow(src, std::min(src_y + 1, src_height - 1),
+        order), src_width, row_buf_[1].data());
+      buf_row[1] = src_y + 1;
+    }
+
+    kernels.resize_blend_rows(row_buf_[0].data(), row_buf_[1].data(),
+      y_weight_[y], dest->data + y * dest_stride, rect.width);
+  }
+}
+
+const uint8_t* ImageResizer::GetGrayRow(const seeta::ImageData & src,
+    int32_t y, ChannelOrder order) {
+  const uint8_t* row = src.data + y * src.GetStride();
+  if (src.num_channels == 1 && src.width > 1)
+    return row;
+  int32_t begin = x_offset_.front();
+  int32_t end = std::min(x_offset_.back() + 2, src.width);
+  ConvertRowToGray(row + begin * src.num_channels, end - begin,
+    src.num_channels, order, gray_row_.data() + begin);
+  // A single source column is replicated, as two columns are interpolated
+  if (src.width == 1)
+    gray_row_[1] = gray_row_[0];
+  return gray_row_.data();
+}
+
+void ImageResizer::ComputeTable(int32_t src_len, int32_t dest_len,
+    int32_t begin, int32_t len, std::vector<int32_t>* offset,
+    std::vector<int32_t>* weight) {
+  double scale = static_cast<double>(src_len) / dest_len;
+  int32_t max_weight = 1 << kResizeWeightBits;
+
+  offset->resize(len);
+  weight->resize(len);
+  for (int32_t i = 0; i < len; i++) {
+    double pos = scale * (begin + i);
+    int32_t n = static_cast<int32_t>(pos);
+    n = std::max(n <= src_len - 2 ? n : src_len - 2, 0);
+
+    int32_t w = static_cast<int32_t>((pos - n) * max_weight + 0.5);
+    (*offset)[i] = n;
+    (*weight)[i] = (w <= max_weight ? w : max_weight);
+  }
+}
+
+void ImageResizer::InterpolateRow(const uint8_t* src, int32_t src_width,
+    int32_t* dest) const {
+  seeta::fd::GetSIMDKernels().resize_interpolate_row(src, src_width,
+    x_offset_.data(), x_weight_.data(), dest,
+    static_cast<int32_t>(x_offset_.size()));
+}
+
+}  // namespace fd
+}  // namespace seeta
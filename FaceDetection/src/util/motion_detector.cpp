@@ -0,0 +1,208 @@
+/*
+ *
+ * This file is part of the open-source SeetaFace engine, which includes three modules:
+ * SeetaFace Detection, SeetaFace Alignment, and SeetaFace Identification.
+ *
+ * This file is part of the SeetaFace Detection module, containing codes implementing the
+ * face detection method described in the following paper:
+ *
+ *
+ *   Funnel-structured cascade for multi-view face detection with alignment awareness,
+ *   Shuzhe Wu, Meina Kan, Zhenliang He, Shiguang Shan, Xilin Chen.
+ *   In Neurocomputing (under review)
+ *
+ *
+ * Copyright (C) 2016, Visual Information Processing and Learning (VIPL) group,
+ * Institute of Computing Technology, Chinese Academy of Sciences, Beijing, China.
+ *
+ * The codes are mainly developed by Shuzhe Wu (a Ph.D supervised by Prof. Shiguang Shan)
+ *
+ * As an open-source face recognition engine: you can redistribute SeetaFace source codes
+ * and/or modify it under the terms of the BSD 2-Clause License.
+ *
+ * You should have received a copy of the BSD 2-Clause License along with the software.
+ * If not, see < https://opensource.org/licenses/BSD-2-Clause>.
+ *
+ * Contact Info: you can send an email to SeetaFace@vipl.ict.ac.cn for any problems.
+ *
+ * Note: the above information must be kept whenever or wherever the codes are used.
+ *
+ */
+
+
+#include "util/motion_detector.h"
+
+#ifdef USE_SSE
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace seeta {
+namespace fd {
+
+bool MotionDetector::Update(const seeta::ImageData & img) {
+  bool has_background = (img.width == width_ && img.height == height_ &&
+    !background_.empty());
+
+  width_ = img.width;
+  height_ = img.height;
+  num_block_x_ = (width_ + block_size() - 1) / block_size();
+  num_block_y_ = (height_ + block_size() - 1) / block_size();
+  Downsample(img);
+
+  if (!has_background || frame_.empty()) {
+    background_ = frame_;
+    changed_.assign(num_block_x_ * num_block_y_, 1);
+    num_changed_ = num_block_x_ * num_block_y_;
+    return false;
+  }
+
+  ComputeBlockDiff();
+  DilateChanged();
+
+  // Blend the frame into the background with equal weights
+  int32_t len = static_cast<int32_t>(frame_.size());
+  uint8_t* bg = background_.data();
+  const uint8_t* frame = frame_.data();
+  int32_t i = 0;
+#ifdef USE_SSE
+  for (; i + 16 <= len; i += 16) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bg + i));
+    __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(frame + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(bg + i), _mm_avg_epu8(x, y));
+  }
+#endif
+  for (; i < len; i++)
+    bg[i] = static_cast<uint8_t>((bg[i] + frame[i] + 1) >> 1);
+  return true;
+}
+
+bool MotionDetector::IsChanged(const seeta::Rect & rect) const {
+  int32_t x1 = std::max(rect.x, 0);
+  int32_t y1 = std::max(rect.y, 0);
+  int32_t x2 = std::min(rect.x + rect.width, width_);
+  int32_t y2 = std::min(rect.y + rect.height, height_);
+  if (x2 <= x1 || y2 <= y1)
+    return false;
+
+  for (int32_t by = y1 / block_size(); by <= (y2 - 1) / block_size(); by++) {
+    const uint8_t* changed = changed_.data() + by * num_block_x_;
+    for (int32_t bx = x1 / block_size(); bx <= (x2 - 1) / block_size(); bx++) {
+      if (changed[bx] != 0)
+        return true;
+    }
+  }
+  return false;
+}
+
+void MotionDetector::Downsample(const seeta::ImageData & img) {
+  int32_t width = img.width / kDownsample;
+  int32_t height = img.height / kDownsample;
+  int32_t stride = img.GetStride();
+  frame_.resize(width * height);
+  if (img.num_channels != 1) {
+    stride = img.width;
+    gray_rows_.resize(kDownsample * stride);
+  }
+
+  for (int32_t r = 0; r < height; r++) {
+    const uint8_t* src = img.data + r * kDownsample * img.GetStride();
+    if (img.num_channels != 1) {
+      for (int32_t k = 0; k < kDownsample; k++) {
+        ConvertRowToGray(src + k * img.GetStride(), img.width,
+          img.num_channels, kChannelBGR, gray_rows_.data() + k * stride);
+      }
+      src = gray_rows_.data();
+    }
+    uint8_t* dest = frame_.data() + r * width;
+    int32_t c = 0;
+#ifdef USE_SSE
+    // Sums of pixel pairs over the rows, then of pairs of those
+    const __m128i ones_8 = _mm_set1_epi8(1);
+    const __m128i ones_16 = _mm_set1_epi16(1);
+    for (; c + 4 <= width; c += 4) {
+      __m128i sum = _mm_setzero_si128();
+      for (int32_t k = 0; k < kDownsample; k++) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+          src + k * stride + c * kDownsample));
+        sum = _mm_add_epi16(sum, _mm_maddubs_epi16(x, ones_8));
+      }
+      sum = _mm_madd_epi16(sum, ones_16);
+      sum = _mm_srli_epi32(_mm_add_epi32(sum, _mm_set1_epi32(8)), 4);
+      sum = _mm_packus_epi16(_mm_packs_epi32(sum, sum), sum);
+      int32_t packed = _mm_cvtsi128_si32(sum);
+      std::memcpy(dest + c, &packed, sizeof(int32_t));
+    }
+#endif
+    for (; c < width; c++) {
+      int32_t sum = 0;
+      for (int32_t k = 0; k < kDownsample; k++) {
+        const uint8_t* p = src + k * stride + c * kDownsample;
+        for (int32_t j = 0; j < kDownsample; j++)
+          sum += p[j];
+      }
+      dest[c] = static_cast<uint8_t>((sum + 8) >> 4);
+    }
+  }
+}
+
+void MotionDetector::ComputeBlockDiff() {
+  int32_t width = width_ / kDownsample;
+  int32_t height = height_ / kDownsample;
+  block_diff_.assign(num_block_x_ * num_block_y_, 0);
+
+  for (int32_t r = 0; r < height; r++) {
+    const uint8_t* frame = frame_.data() + r * width;
+    const uint8_t* bg = background_.data() + r * width;
+    int32_t* diff = block_diff_.data() + (r / kBlockCell) * num_block_x_;
+    int32_t c = 0;
+#ifdef USE_SSE
+    // Sums of absolute differences of 8 pixels each, i.e. one block row
+    for (; c + 16 <= width; c += 16) {
+      __m128i sad = _mm_sad_epu8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(frame + c)),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(bg + c)));
+      diff[c / kBlockCell] += _mm_cvtsi128_si32(sad);
+      diff[c / kBlockCell + 1] += _mm_extract_epi32(sad, 2);
+    }
+#endif
+    for (; c < width; c++)
+      diff[c / kBlockCell] += std::abs(frame[c] - bg[c]);
+  }
+
+  int32_t width_last = width - (num_block_x_ - 1) * kBlockCell;
+  int32_t height_last = height - (num_block_y_ - 1) * kBlockCell;
+  changed_.resize(num_block_x_ * num_block_y_);
+  for (int32_t by = 0; by < num_block_y_; by++) {
+    int32_t h = (by == num_block_y_ - 1 ? height_last : kBlockCell);
+    for (int32_t bx = 0; bx < num_block_x_; bx++) {
+      int32_t w = (bx == num_block_x_ - 1 ? width_last : kBlockCell);
+      int32_t idx = by * num_block_x_ + bx;
+      changed_[idx] = (w > 0 && h > 0 && block_diff_[idx] > thresh_ * w * h);
+    }
+  }
+}
+
+void MotionDetector::DilateChanged() {
+  changed_buf_ = changed_;
+  num_changed_ = 0;
+  for (int32_t by = 0; by < num_block_y_; by++) {
+    for (int32_t bx = 0; bx < num_block_x_; bx++) {
+      uint8_t is_changed = 0;
+      for (int32_t y = std::max(by - 1, 0);
+          y <= std::min(by + 1, num_block_y_ - 1); y++) {
+        for (int32_t x = std::max(bx - 1, 0);
+            x <= std::min(bx + 1, num_block_x_ - 1); x++)
+          is_changed |= changed_buf_[y * num_block_x_ + x];
+      }
+      changed_[by * num_block_x_ + bx] = is_changed;
+      num_changed_ += is_changed;
+    }
+  }
+}
+
+}  // namespace fd
+}  // namespace seeta
@@ -33,16 +33,42 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <unordered_map>
 #include <vector>
 
 namespace seeta {
 namespace fd {
 
+/** Inputs up to this size are suppressed by comparing all pairs */
+static const int32_t kMaxNumBBoxPairwise = 256;
+/** Number of size classes of the grid, box sides ranging up to 2^kNumSizeClass */
+static const int32_t kNumSizeClass = 31;
+
 bool CompareBBox(const seeta::FaceInfo & a, const seeta::FaceInfo & b) {
   return a.score > b.score;
 }
 
-void NonMaximumSuppression(std::vector<seeta::FaceInfo>* bboxes,
+/**
+ * Whether `bbox` overlaps the box with corners (x1, y1) and (x2, y2) and area
+ * `area1` by more than `iou_thresh`. Kept in one place so that both
+ * implementations give bit-identical decisions.
+ */
+static inline bool IsOverlapped(float x1, float y1, float x2, float y2,
+    float area1, const seeta::Rect & bbox, float iou_thresh) {
+  float x = std::max<float>(x1, static_cast<float>(bbox.x));
+  float y = std::max<float>(y1, static_cast<float>(bbox.y));
+  float w = std::min<float>(x2, static_cast<float>(bbox.x + bbox.width - 1)) - x + 1;
+  float h = std::min<float>(y2, static_cast<float>(bbox.y + bbox.height - 1)) - y + 1;
+  if (w <= 0 || h <= 0)
+    return false;
+
+  float area2 = static_cast<float>(bbox.width * bbox.height);
+  float area_intersect = w * h;
+  float area_union = area1 + area2 - area_intersect;
+  return (static_cast<float>(area_intersect) / area_union > iou_thresh);
+}
+
+void NonMaximumSuppressionPairwise(std::vector<seeta::FaceInfo>* bboxes,
   std::vector<seeta::FaceInfo>* bboxes_nms, float iou_thresh) {
   bboxes_nms->clear();
   std::sort(bboxes->begin(), bboxes->end(), seeta::fd::CompareBBox);
@@ -74,23 +100,126 @@ void NonMaximumSuppression(std::vector<seeta::FaceInfo>* bboxes,
     for (int32_t i = select_idx; i < num_bbox; i++) {
       if (mask_merged[i] == 1)
         continue;
+      if (IsOverlapped(x1, y1, x2, y2, area1, (*bboxes)[i].bbox, iou_thresh)) {
+        mask_merged[i] = 1;
+        bboxes_nms->back().score += (*bboxes)[i].score;
+      }
+    }
+  }
+}
 
-      seeta::Rect & bbox_i = (*bboxes)[i].bbox;
-      float x = std::max<float>(x1, static_cast<float>(bbox_i.x));
-      float y = std::max<float>(y1, static_cast<float>(bbox_i.y));
-      float w = std::min<float>(x2, static_cast<float>(bbox_i.x + bbox_i.width - 1)) - x + 1;
-      float h = std::min<float>(y2, static_cast<float>(bbox_i.y + bbox_i.height - 1)) - y + 1;
-      if (w <= 0 || h <= 0)
+/** Floor of log2 of a positive `x` */
+static inline int32_t FloorLog2(int32_t x) {
+  int32_t n = 0;
+  while (x > 1) {
+    x >>= 1;
+    n++;
+  }
+  return n;
+}
+
+/** Floor of `x / 2^shift`, also for negative `x` */
+static inline int32_t FloorShift(int32_t x, int32_t shift) {
+  return (x >= 0 ? x >> shift : -((-x - 1) >> shift) - 1);
+}
+
+static inline int64_t CellKey(int32_t cell_x, int32_t cell_y) {
+  return (static_cast<int64_t>(cell_x) << 32) ^
+    static_cast<int64_t>(static_cast<uint32_t>(cell_y));
+}
+
+void NonMaximumSuppression(std::vector<seeta::FaceInfo>* bboxes,
+  std::vector<seeta::FaceInfo>* bboxes_nms, float iou_thresh) {
+  int32_t num_bbox = static_cast<int32_t>(bboxes->size());
+  if (num_bbox <= kMaxNumBBoxPairwise || iou_thresh <= 0) {
+    NonMaximumSuppressionPairwise(bboxes, bboxes_nms, iou_thresh);
+    return;
+  }
+
+  bboxes_nms->clear();
+  std::sort(bboxes->begin(), bboxes->end(), seeta::fd::CompareBBox);
+
+  // Boxes whose longer side lies in [2^k, 2^(k+1)) go to the grid of size
+  // class k, whose cells are 2^(k+1) wide, by their top-left corner. A box
+  // can then only overlap boxes of class k whose corner lies in the cells
+  // covering its own extent plus one cell up and to the left. Boxes with no
+  // area never overlap anything and are left out.
+  std::vector<std::unordered_map<int64_t, std::vector<int32_t> > >
+    grid(kNumSizeClass);
+  std::vector<int32_t> size_class(num_bbox, -1);
+  for (int32_t i = 0; i < num_bbox; i++) {
+    const seeta::Rect & bbox = (*bboxes)[i].bbox;
+    if (bbox.width <= 0 || bbox.height <= 0)
+      continue;
+    int32_t k = std::min(FloorLog2(std::max(bbox.width, bbox.height)),
+      kNumSizeClass - 1);
+    size_class[i] = k;
+    grid[k][CellKey(FloorShift(bbox.x, k + 1), FloorShift(bbox.y, k + 1))]
+      .push_back(i);
+  }
+
+  std::vector<int32_t> mask_merged(num_bbox, 0);
+  std::vector<int32_t> merged_idx;
+  for (int32_t select_idx = 0; select_idx < num_bbox; select_idx++) {
+    if (mask_merged[select_idx] == 1)
+      continue;
+
+    bboxes_nms->push_back((*bboxes)[select_idx]);
+    mask_merged[select_idx] = 1;
+    if (size_class[select_idx] < 0)
+      continue;
+
+    seeta::Rect select_bbox = (*bboxes)[select_idx].bbox;
+    float area1 = static_cast<float>(select_bbox.width * select_bbox.height);
+    float x1 = static_cast<float>(select_bbox.x);
+    float y1 = static_cast<float>(select_bbox.y);
+    float x2 = static_cast<float>(select_bbox.x + select_bbox.width - 1);
+    float y2 = static_cast<float>(select_bbox.y + select_bbox.height - 1);
+
+    merged_idx.clear();
+    for (int32_t k = 0; k < kNumSizeClass; k++) {
+      // The IoU is at most the ratio of the smaller area to the larger one,
+      // which is checked with some margin for rounding
+      double max_area = static_cast<double>(int64_t(1) << (k + 1)) *
+        static_cast<double>(int64_t(1) << (k + 1));
+      if (grid[k].empty() || max_area < 0.99 * iou_thresh * area1)
         continue;
 
-      float area2 = static_cast<float>(bbox_i.width * bbox_i.height);
-      float area_intersect = w * h;
-      float area_union = area1 + area2 - area_intersect;
-      if (static_cast<float>(area_intersect) / area_union > iou_thresh) {
-        mask_merged[i] = 1;
-        bboxes_nms->back().score += (*bboxes)[i].score;
+      int32_t cell_x1 = FloorShift(select_bbox.x, k + 1) - 1;
+      int32_t cell_y1 = FloorShift(select_bbox.y, k + 1) - 1;
+      int32_t cell_x2 = FloorShift(select_bbox.x + select_bbox.width - 1, k + 1);
+      int32_t cell_y2 = FloorShift(select_bbox.y + select_bbox.height - 1, k + 1);
+      for (int32_t cell_y = cell_y1; cell_y <= cell_y2; cell_y++) {
+        for (int32_t cell_x = cell_x1; cell_x <= cell_x2; cell_x++) {
+          std::unordered_map<int64_t, std::vector<int32_t> >::iterator cell =
+            grid[k].find(CellKey(cell_x, cell_y));
+          if (cell == grid[k].end())
+            continue;
+
+          // Drop boxes merged or selected earlier while scanning the cell
+          std::vector<int32_t> & cell_idx = cell->second;
+          size_t num_left = 0;
+          for (size_t j = 0; j < cell_idx.size(); j++) {
+            int32_t i = cell_idx[j];
+            if (mask_merged[i] == 1)
+              continue;
+            cell_idx[num_left++] = i;
+            if (IsOverlapped(x1, y1, x2, y2, area1, (*bboxes)[i].bbox,
+                iou_thresh))
+              merged_idx.push_back(i);
+          }
+          cell_idx.resize(num_left);
+        }
       }
     }
+
+    // Scores are accumulated in the order of the sorted boxes, as when
+    // comparing all pairs
+    std::sort(merged_idx.begin(), merged_idx.end());
+    for (size_t j = 0; j < merged_idx.size(); j++) {
+      mask_merged[merged_idx[j]] = 1;
+      bboxes_nms->back().score += (*bboxes)[merged_idx[j]].score;
+    }
   }
 }
 
@@ -0,0 +1,310 @@
+/*
+ *
+ * This file is part of the open-source SeetaFace engine, which includes three modules:
+ * SeetaFace Detection, SeetaFace Alignment, and SeetaFace Identification.
+ *
+ * This file is part of the SeetaFace Detection module, containing codes implementing the
+ * face detection method described in the following paper:
+ *
+ *
+ *   Funnel-structured cascade for multi-view face detection with alignment awareness,
+ *   Shuzhe Wu, Meina Kan, Zhenliang He, Shiguang Shan, Xilin Chen.
+ *   In Neurocomputing (under review)
+ *
+ *
+ * Copyright (C) 2016, Visual Information Processing and Learning (VIPL) group,
+ * Institute of Computing Technology, Chinese Academy of Sciences, Beijing, China.
+ *
+ * The codes are mainly developed by Shuzhe Wu (a Ph.D supervised by Prof. Shiguang Shan)
+ *
+ * As an open-source face recognition engine: you can redistribute SeetaFace source codes
+ * and/or modify it under the terms of the BSD 2-Clause License.
+ *
+ * You should have received a copy of the BSD 2-Clause License along with the software.
+ * If not, see < https://opensource.org/licenses/BSD-2-Clause>.
+ *
+ * Contact Info: you can send an email to SeetaFace@vipl.ict.ac.cn for any problems.
+ *
+ * Note: the above information must be kept whenever or wherever the codes are used.
+ *
+ */
+
+
+
+#include "util/simd_kernels.h"
+
+#ifdef USE_SSE
+#include <immintrin.h>
+#endif
+
+#include "util/cpu_features.h"
+
+namespace seeta {
+namespace fd {
+
+static void VectorAdd(const int32_t* x, const int32_t* y, int32_t* z,
+    int32_t len) {
+  int32_t i;
+#ifdef USE_SSE
+  __m128i x1;
+  __m128i y1;
+  const __m128i* x2 = reinterpret_cast<const __m128i*>(x);
+  const __m128i* y2 = reinterpret_cast<const __m128i*>(y);
+  __m128i* z2 = reinterpret_cast<__m128i*>(z);
+
+  for (i = 0; i < len - 4; i += 4) {
+    x1 = _mm_loadu_si128(x2++);
+    y1 = _mm_loadu_si128(y2++);
+    _mm_storeu_si128(z2++, _mm_add_epi32(x1, y1));
+  }
+  for (; i < len; i++)
+    *(z + i) = (*(x + i)) + (*(y + i));
+#else
+  for (i = 0; i < len; i++)
+    *(z + i) = (*(x + i)) + (*(y + i));
+#endif
+}
+
+static void VectorSub(const int32_t* x, const int32_t* y, int32_t* z,
+    int32_t len) {
+  int32_t i;
+#ifdef USE_SSE
+  __m128i x1;
+  __m128i y1;
+  const __m128i* x2 = reinterpret_cast<const __m128i*>(x);
+  const __m128i* y2 = reinterpret_cast<const __m128i*>(y);
+  __m128i* z2 = reinterpret_cast<__m128i*>(z);
+
+  for (i = 0; i < len - 4; i += 4) {
+    x1 = _mm_loadu_si128(x2++);
+    y1 = _mm_loadu_si128(y2++);
+
+    _mm_storeu_si128(z2++, _mm_sub_epi32(x1, y1));
+  }
+  for (; i < len; i++)
+    *(z + i) = (*(x + i)) - (*(y + i));
+#else
+  for (i = 0; i < len; i++)
+    *(z + i) = (*(x + i)) - (*(y + i));
+#endif
+}
+
+static void VectorAbs(const int32_t* src, int32_t* dest, int32_t len) {
+  int32_t i;
+#ifdef USE_SSE
+  __m128i val;
+  __m128i val_abs;
+  const __m128i* x = reinterpret_cast<const __m128i*>(src);
+  __m128i* y = reinterpret_cast<__m128i*>(dest);
+
+  for (i = 0; i < len - 4; i += 4) {
+    val = _mm_loadu_si128(x++);
+    val_abs = _mm_abs_epi32(val);
+    _mm_storeu_si128(y++, val_abs);
+  }
+  for (; i < len; i++)
+    dest[i] = (src[i] >= 0 ? src[i] : -src[i]);
+#else
+  for (i = 0; i < len; i++)
+    dest[i] = (src[i] >= 0 ? src[i] : -src[i]);
+#endif
+}
+
+static void Square(const int32_t* src, uint32_t* dest, int32_t len) {
+  int32_t i;
+#ifdef USE_SSE
+  __m128i x1;
+  const __m128i* x2 = reinterpret_cast<const __m128i*>(src);
+  __m128i* y2 = reinterpret_cast<__m128i*>(dest);
+
+  for (i = 0; i < len - 4; i += 4) {
+    x1 = _mm_loadu_si128(x2++);
+    _mm_storeu_si128(y2++, _mm_mullo_epi32(x1, x1));
+  }
+  for (; i < len; i++)
+    *(dest + i) = (*(src + i)) * (*(src + i));
+#else
+  for (i = 0; i < len; i++)
+    *(dest + i) = (*(src + i)) * (*(src + i));
+#endif
+}
+
+static float VectorInnerProduct(const float* x, const float* y,
+    int32_t len) {
+  float prod = 0;
+  int32_t i;
+#ifdef USE_SSE
+  __m128 x1;
+  __m128 y1;
+  __m128 z1 = _mm_setzero_ps();
+  float buf[4];
+
+  for (i = 0; i < len - 4; i += 4) {
+    x1 = _mm_loadu_ps(x + i);
+    y1 = _mm_loadu_ps(y + i);
+    z1 = _mm_add_ps(z1, _mm_mul_ps(x1, y1));
+  }
+  _mm_storeu_ps(&buf[0], z1);
+  prod = buf[0] + buf[1] + buf[2] + buf[3];
+  for (; i < len; i++)
+    prod += x[i] * y[i];
+#else
+  for (i = 0; i < len; i++)
+      prod += x[i] * y[i];
+#endif
+  return prod;
+}
+
+static void InnerProductBlockInt8(const int16_t* const* x, const int8_t* w,
+    int32_t len, int32_t* prod) {
+  const int16_t* x0 = x[0];
+  const int16_t* x1 = x[1];
+  const int16_t* x2 = x[2];
+  const int16_t* x3 = x[3];
+#ifdef USE_SSE
+  __m128i z[4];
+  __m128i w1;
+  for (int32_t k = 0; k < 4; k++)
+    z[k] = _mm_setzero_si128();
+
+  for (int32_t i = 0; i < len; i += 8) {
+    w1 = _mm_cvtepi8_epi16(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(w + i)));
+    z[0] = _mm_add_epi32(z[0], _mm_madd_epi16(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(x0 + i)), w1));
+    z[1] = _mm_add_epi32(z[1], _mm_madd_epi16(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(x1 + i)), w1));
+    z[2] = _mm_add_epi32(z[2], _mm_madd_epi16(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(x2 + i)), w1));
+    z[3] = _mm_add_epi32(z[3], _mm_madd_epi16(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(x3 + i)), w1));
+  }
+  for (int32_t k = 0; k < 4; k++) {
+    __m128i sum = _mm_hadd_epi32(z[k], z[k]);
+    sum = _mm_hadd_epi32(sum, sum);
+    prod[k] = _mm_cvtsi128_si32(sum);
+  }
+#else
+  prod[0] = prod[1] = prod[2] = prod[3] = 0;
+  for (int32_t i = 0; i < len; i++) {
+    prod[0] += x0[i] * w[i];
+    prod[1] += x1[i] * w[i];
+    prod[2] += x2[i] * w[i];
+    prod[3] += x3[i] * w[i];
+  }
+#endif
+}
+
+static void ResizeInterpolateRow(const uint8_t* src, int32_t src_width,
+    const int32_t* offset, const int32_t* weight, int32_t* dest,
+    int32_t dest_width) {
+  for (int32_t x = 0; x < dest_width; x++) {
+    int32_t left = src[offset[x]];
+    int32_t right = src[offset[x] + 1];
+    dest[x] = (left << kResizeWeightBits) + (right - left) * weight[x];
+  }
+}
+
+static void ResizeBlendRows(const int32_t* row0, const int32_t* row1,
+    int32_t weight, uint8_t* dest, int32_t len) {
+  const int32_t shift = kResizeWeightBits * 2;
+  int32_t i = 0;
+
+#ifdef USE_SSE
+  __m128i w = _mm_set1_epi32(weight);
+  for (; i + 8 <= len; i += 8) {
+    __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + i));
+    __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + i));
+    __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + i + 4));
+    __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + i + 4));
+    __m128i v0 = _mm_srai_epi32(_mm_add_epi32(
+      _mm_slli_epi32(a0, kResizeWeightBits),
+      _mm_mullo_epi32(_mm_sub_epi32(b0, a0), w)), shift);
+    __m128i v1 = _mm_srai_epi32(_mm_add_epi32(
+      _mm_slli_epi32(a1, kResizeWeightBits),
+      _mm_mullo_epi32(_mm_sub_epi32(b1, a1), w)), shift);
+    __m128i v = _mm_packus_epi32(v0, v1);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dest + i),
+      _mm_packus_epi16(v, v));
+  }
+#endif
+  for (; i < len; i++) {
+    int32_t val = ((row0[i] << kResizeWeightBits) +
+      (row1[i] - row0[i]) * weight) >> shift;
+    dest[i] = static_cast<uint8_t>(val < 0 ? 0 : (val > 255 ? 255 : val));
+  }
+}
+
+static void LABCodeRow(const int32_t* white, const int32_t* black,
+    const int32_t* black_offset, uint8_t* dest, int32_t len) {
+  for (int32_t c = 0; c < len; c++) {
+    uint8_t code = 0;
+    for (int32_t i = 0; i < 8; i++) {
+      if (white[c] >= black[c + black_offset[i]])
+        code |= static_cast<uint8_t>(kLABCodeBit[i]);
+    }
+    dest[c] = code;
+  }
+}
+
+template<typename WeightType>
+static int32_t LABClassifyGroup(const uint8_t* feat_val,
+    const int32_t* wnd_offset, const int32_t* feat_offset, int32_t num_feat,
+    const WeightType* weights, int32_t weight_stride, float thresh,
+    int32_t num_alive, int32_t* wnd_idx, float* wnd_score) {
+  int32_t num_pos = 0;
+  for (int32_t k = 0; k < num_alive; k++) {
+    const uint8_t* wnd_feat_val = feat_val + wnd_offset[wnd_idx[k]];
+    float s = wnd_score[k];
+    for (int32_t j = 0; j < num_feat; j++) {
+      uint8_t val = wnd_feat_val[feat_offset[j]];
+      s += static_cast<float>(weights[j * weight_stride + val]);
+    }
+    if (!(s < thresh)) {
+      wnd_idx[num_pos] = wnd_idx[k];
+      wnd_score[num_pos] = s;
+      num_pos++;
+    }
+  }
+  return num_pos;
+}
+
+static SIMDKernels BindKernels() {
+  SIMDKernels kernels;
+#ifdef USE_SSE
+  kernels.isa = "sse4.1";
+#else
+  kernels.isa = "scalar";
+#endif
+  kernels.vector_add = VectorAdd;
+  kernels.vector_sub = VectorSub;
+  kernels.vector_abs = VectorAbs;
+  kernels.square = Square;
+  kernels.vector_inner_product = VectorInnerProduct;
+  kernels.inner_product_block_int8 = InnerProductBlockInt8;
+  kernels.resize_interpolate_row = ResizeInterpolateRow;
+  kernels.resize_blend_rows = ResizeBlendRows;
+  kernels.lab_code_row = LABCodeRow;
+  kernels.lab_classify_group = LABClassifyGroup<float>;
+  kernels.lab_classify_group_int16 = LABClassifyGroup<int16_t>;
+
+  const seeta::fd::CPUFeatures & features = seeta::fd::GetCPUFeatures();
+#ifdef USE_AVX2
+  if (features.avx2)
+    BindAVX2Kernels(&kernels);
+#endif
+#ifdef USE_AVX512
+  if (features.avx512f)
+    BindAVX512Kernels(&kernels);
+#endif
+  (void)features;
+  return kernels;
+}
+
+const SIMDKernels & GetSIMDKernels() {
+  static const SIMDKernels kernels = BindKernels();
+  return kernels;
+}
+
+}  // namespace fd
+}  // namespace seeta
@@ -0,0 +1,320 @@
+/*
+ *
+ * This file is part of the open-source SeetaFace engine, which includes three modules:
+ * SeetaFace Detection, SeetaFace Alignment, and SeetaFace Identification.
+ *
+ * This file is part of the SeetaFace Detection module, containing codes implementing the
+ * face detection method described in the following paper:
+ *
+ *
+ *   Funnel-structured cascade for multi-view face detection with alignment awareness,
+ *   Shuzhe Wu, Meina Kan, Zhenliang He, Shiguang Shan, Xilin Chen.
+ *   In Neurocomputing (under review)
+ *
+ *
+ * Copyright (C) 2016, Visual Information Processing and Learning (VIPL) group,
+ * Institute of Computing Technology, Chinese Academy of Sciences, Beijing, China.
+ *
+ * The codes are mainly developed by Shuzhe Wu (a Ph.D supervised by Prof. Shiguang Shan)
+ *
+ * As an open-source face recognition engine: you can redistribute SeetaFace source codes
+ * and/or modify it under the terms of the BSD 2-Clause License.
+ *
+ * You should have received a copy of the BSD 2-Clause License along with the software.
+ * If not, see < https://opensource.org/licenses/BSD-2-Clause>.
+ *
+ * Contact Info: you can send an email to SeetaFace@vipl.ict.ac.cn for any problems.
+ *
+ * Note: the above information must be kept whenever or wherever the codes are used.
+ *
+ */
+
+
+
+/*
+ * Built with AVX2 enabled. Only headers of intrinsics and plain declarations
+ * may be included here: an inline function shared with other files could
+ * end up in the library as built here, and fault on older CPUs.
+ */
+
+#include "util/simd_kernels.h"
+
+#ifdef USE_AVX2
+
+#include <immintrin.h>
+
+namespace seeta {
+namespace fd {
+
+static void VectorAdd(const int32_t* x, const int32_t* y, int32_t* z,
+    int32_t len) {
+  int32_t i;
+  __m256i x1;
+  __m256i y1;
+  const __m256i* x2 = reinterpret_cast<const __m256i*>(x);
+  const __m256i* y2 = reinterpret_cast<const __m256i*>(y);
+  __m256i* z2 = reinterpret_cast<__m256i*>(z);
+
+  for (i = 0; i < len - 8; i += 8) {
+    x1 = _mm256_loadu_si256(x2++);
+    y1 = _mm256_loadu_si256(y2++);
+    _mm256_storeu_si256(z2++, _mm256_add_epi32(x1, y1));
+  }
+  for (; i < len; i++)
+    *(z + i) = (*(x + i)) + (*(y + i));
+}
+
+static void VectorSub(const int32_t* x, const int32_t* y, int32_t* z,
+    int32_t len) {
+  int32_t i;
+  __m256i x1;
+  __m256i y1;
+  const __m256i* x2 = reinterpret_cast<const __m256i*>(x);
+  const __m256i* y2 = reinterpret_cast<const __m256i*>(y);
+  __m256i* z2 = reinterpret_cast<__m256i*>(z);
+
+  for (i = 0; i < len - 8; i += 8) {
+    x1 = _mm256_loadu_si256(x2++);
+    y1 = _mm256_loadu_si256(y2++);
+
+    _mm256_storeu_si256(z2++, _mm256_sub_epi32(x1, y1));
+  }
+  for (; i < len; i++)
+    *(z + i) = (*(x + i)) - (*(y + i));
+}
+
+static void VectorAbs(const int32_t* src, int32_t* dest, int32_t len) {
+  int32_t i = 0;
+  for (; i + 8 <= len; i += 8) {
+    __m256i val = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i),
+      _mm256_abs_epi32(val));
+  }
+  for (; i < len; i++)
+    dest[i] = (src[i] >= 0 ? src[i] : -src[i]);
+}
+
+static void Square(const int32_t* src, uint32_t* dest, int32_t len) {
+  int32_t i = 0;
+  for (; i + 8 <= len; i += 8) {
+    __m256i val = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i),
+      _mm256_mullo_epi32(val, val));
+  }
+  for (; i < len; i++)
+    *(dest + i) = (*(src + i)) * (*(src + i));
+}
+
+static void InnerProductBlockInt8(const int16_t* const* x, const int8_t* w,
+    int32_t len, int32_t* prod) {
+  const int16_t* x0 = x[0];
+  const int16_t* x1 = x[1];
+  const int16_t* x2 = x[2];
+  const int16_t* x3 = x[3];
+  __m256i z[4];
+  __m256i w1;
+  for (int32_t k = 0; k < 4; k++)
+    z[k] = _mm256_setzero_si256();
+
+  for (int32_t i = 0; i < len; i += 16) {
+    w1 = _mm256_cvtepi8_epi16(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(w + i)));
+    z[0] = _mm256_add_epi32(z[0], _mm256_madd_epi16(
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x0 + i)), w1));
+    z[1] = _mm256_add_epi32(z[1], _mm256_madd_epi16(
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x1 + i)), w1));
+    z[2] = _mm256_add_epi32(z[2], _mm256_madd_epi16(
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x2 + i)), w1));
+    z[3] = _mm256_add_epi32(z[3], _mm256_madd_epi16(
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x3 + i)), w1));
+  }
+  for (int32_t k = 0; k < 4; k++) {
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(z[k]),
+      _mm256_extracti128_si256(z[k], 1));
+    sum = _mm_hadd_epi32(sum, sum);
+    sum = _mm_hadd_epi32(sum, sum);
+    prod[k] = _mm_cvtsi128_si32(sum);
+  }
+}
+
+static void ResizeInterpolateRow(const uint8_t* src, int32_t src_width,
+    const int32_t* offset, const int32_t* weight, int32_t* dest,
+    int32_t dest_width) {
+  int32_t x = 0;
+
+  // Each 32-bit gather brings in both neighbours of a column. Stop before a
+  // gather could read past the end of the row.
+  const __m256i mask = _mm256_set1_epi32(0xFF);
+  for (; x + 8 <= dest_width && offset[x + 7] + 4 <= src_width; x += 8) {
+    __m256i ofs = _mm256_loadu_si256(
+      reinterpret_cast<const __m256i*>(offset + x));
+    __m256i w = _mm256_loadu_si256(
+      reinterpret_cast<const __m256i*>(weight + x));
+    __m256i pix = _mm256_i32gather_epi32(reinterpret_cast<const int*>(src),
+      ofs, 1);
+    __m256i left = _mm256_and_si256(pix, mask);
+    __m256i right = _mm256_and_si256(_mm256_srli_epi32(pix, 8), mask);
+    __m256i val = _mm256_add_epi32(_mm256_slli_epi32(left, kResizeWeightBits),
+      _mm256_mullo_epi32(_mm256_sub_epi32(right, left), w));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + x), val);
+  }
+  for (; x < dest_width; x++) {
+    int32_t left = src[offset[x]];
+    int32_t right = src[offset[x] + 1];
+    dest[x] = (left << kResizeWeightBits) + (right - left) * weight[x];
+  }
+}
+
+static void ResizeBlendRows(const int32_t* row0, const int32_t* row1,
+    int32_t weight, uint8_t* dest, int32_t len) {
+  const int32_t shift = kResizeWeightBits * 2;
+  int32_t i = 0;
+
+  __m256i w = _mm256_set1_epi32(weight);
+  for (; i + 16 <= len; i += 16) {
+    __m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row0 + i));
+    __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row1 + i));
+    __m256i a1 = _mm256_loadu_si256(
+      reinterpret_cast<const __m256i*>(row0 + i + 8));
+    __m256i b1 = _mm256_loadu_si256(
+      reinterpret_cast<const __m256i*>(row1 + i + 8));
+    __m256i v0 = _mm256_srai_epi32(_mm256_add_epi32(
+      _mm256_slli_epi32(a0, kResizeWeightBits),
+      _mm256_mullo_epi32(_mm256_sub_epi32(b0, a0), w)), shift);
+    __m256i v1 = _mm256_srai_epi32(_mm256_add_epi32(
+      _mm256_slli_epi32(a1, kResizeWeightBits),
+      _mm256_mullo_epi32(_mm256_sub_epi32(b1, a1), w)), shift);
+    // packus works within 128-bit lanes, so restore the order of the halves
+    __m256i v = _mm256_permute4x64_epi64(_mm256_packus_epi32(v0, v1), 0xD8);
+    __m128i pix = _mm_packus_epi16(_mm256_castsi256_si128(v),
+      _mm256_extracti128_si256(v, 1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), pix);
+  }
+  for (; i < len; i++) {
+    int32_t val = ((row0[i] << kResizeWeightBits) +
+      (row1[i] - row0[i]) * weight) >> shift;
+    dest[i] = static_cast<uint8_t>(val < 0 ? 0 : (val > 255 ? 255 : val));
+  }
+}
+
+/** LAB codes of 8 consecutive positions, one per 32-bit lane */
+static inline __m256i LABCode8(const int32_t* white, const int32_t* black,
+    const int32_t* black_offset) {
+  __m256i white_sum = _mm256_loadu_si256(
+    reinterpret_cast<const __m256i*>(white));
+  __m256i code = _mm256_setzero_si256();
+  for (int32_t i = 0; i < 8; i++) {
+    __m256i black_sum = _mm256_loadu_si256(
+      reinterpret_cast<const __m256i*>(black + black_offset[i]));
+    // white >= black, i.e. not black > white
+    __m256i lt = _mm256_cmpgt_epi32(black_sum, white_sum);
+    code = _mm256_or_si256(code,
+      _mm256_andnot_si256(lt, _mm256_set1_epi32(kLABCodeBit[i])));
+  }
+  return code;
+}
+
+static void LABCodeRow(const int32_t* white, const int32_t* black,
+    const int32_t* black_offset, uint8_t* dest, int32_t len) {
+  int32_t c = 0;
+  for (; c + 16 <= len; c += 16) {
+    __m256i code0 = LABCode8(white + c, black + c, black_offset);
+    __m256i code1 = LABCode8(white + c + 8, black + c + 8, black_offset);
+    // packus works within 128-bit lanes, so restore the order of halves
+    __m256i code = _mm256_permute4x64_epi64(
+      _mm256_packus_epi32(code0, code1), 0xD8);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + c),
+      _mm_packus_epi16(_mm256_castsi256_si128(code),
+      _mm256_extracti128_si256(code, 1)));
+  }
+  for (; c < len; c++) {
+    uint8_t code = 0;
+    for (int32_t i = 0; i < 8; i++) {
+      if (white[c] >= black[c + black_offset[i]])
+        code |= static_cast<uint8_t>(kLABCodeBit[i]);
+    }
+    dest[c] = code;
+  }
+}
+
+static inline __m256 GatherWeight8(const float* weights, __m256i idx) {
+  return _mm256_i32gather_ps(weights, idx, 4);
+}
+
+static inline __m256 GatherWeight8(const int16_t* weights, __m256i idx) {
+  __m256i w = _mm256_i32gather_epi32(reinterpret_cast<const int*>(weights),
+    idx, 2);
+  return _mm256_cvtepi32_ps(_mm256_srai_epi32(_mm256_slli_epi32(w, 16), 16));
+}
+
+/** 8 windows at a time in lockstep, then the rest one by one */
+template<typename WeightType>
+static int32_t LABClassifyGroup(const uint8_t* feat_val,
+    const int32_t* wnd_offset, const int32_t* feat_offset, int32_t num_feat,
+    const WeightType* weights, int32_t weight_stride, float thresh,
+    int32_t num_alive, int32_t* wnd_idx, float* wnd_score) {
+  const __m256i mask = _mm256_set1_epi32(0xFF);
+  int32_t idx_buf[8];
+  float score_buf[8];
+  int32_t num_pos = 0;
+  int32_t k = 0;
+
+  // Survivors are written back in place: `num_pos` never passes `k`
+  for (; k + 8 <= num_alive; k += 8) {
+    __m256i idx = _mm256_loadu_si256(
+      reinterpret_cast<const __m256i*>(wnd_idx + k));
+    __m256i base = _mm256_i32gather_epi32(wnd_offset, idx, 4);
+    __m256 s = _mm256_loadu_ps(wnd_score + k);
+    for (int32_t j = 0; j < num_feat; j++) {
+      __m256i addr = _mm256_add_epi32(base, _mm256_set1_epi32(feat_offset[j]));
+      __m256i val = _mm256_and_si256(_mm256_i32gather_epi32(
+        reinterpret_cast<const int*>(feat_val), addr, 1), mask);
+      s = _mm256_add_ps(s, GatherWeight8(weights,
+        _mm256_add_epi32(val, _mm256_set1_epi32(j * weight_stride))));
+    }
+    int32_t pos = _mm256_movemask_ps(_mm256_cmp_ps(s, _mm256_set1_ps(thresh),
+      _CMP_NLT_UQ));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(idx_buf), idx);
+    _mm256_storeu_ps(score_buf, s);
+    for (int32_t lane = 0; pos != 0; lane++, pos >>= 1) {
+      if (pos & 1) {
+        wnd_idx[num_pos] = idx_buf[lane];
+        wnd_score[num_pos] = score_buf[lane];
+        num_pos++;
+      }
+    }
+  }
+  for (; k < num_alive; k++) {
+    const uint8_t* wnd_feat_val = feat_val + wnd_offset[wnd_idx[k]];
+    float s = wnd_score[k];
+    for (int32_t j = 0; j < num_feat; j++) {
+      uint8_t val = wnd_feat_val[feat_offset[j]];
+      s += static_cast<float>(weights[j * weight_stride + val]);
+    }
+    if (!(s < thresh)) {
+      wnd_idx[num_pos] = wnd_idx[k];
+      wnd_score[num_pos] = s;
+      num_pos++;
+    }
+  }
+  return num_pos;
+}
+
+void BindAVX2Kernels(SIMDKernels* kernels) {
+  kernels->isa = "avx2";
+  kernels->vector_add = VectorAdd;
+  kernels->vector_sub = VectorSub;
+  kernels->vector_abs = VectorAbs;
+  kernels->square = Square;
+  kernels->inner_product_block_int8 = InnerProductBlockInt8;
+  kernels->resize_interpolate_row = ResizeInterpolateRow;
+  kernels->resize_blend_rows = ResizeBlendRows;
+  kernels->lab_code_row = LABCodeRow;
+  kernels->lab_classify_group = LABClassifyGroup<float>;
+  kernels->lab_classify_group_int16 = LABClassifyGroup<int16_t>;
+}
+
+}  // namespace fd
+}  // namespace seeta
+
+#endif  // USE_AVX2
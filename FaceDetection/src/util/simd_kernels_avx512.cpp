@@ -0,0 +1,143 @@
+/*
+ *
+ * This file is part of the open-source SeetaFace engine, which includes three modules:
+ * SeetaFace Detection, SeetaFace Alignment, and SeetaFace Identification.
+ *
+ * This file is part of the SeetaFace Detection module, containing codes implementing the
+ * face detection method described in the following paper:
+ *
+ *
+ *   Funnel-structured cascade for multi-view face detection with alignment awareness,
+ *   Shuzhe Wu, Meina Kan, Zhenliang He, Shiguang Shan, Xilin Chen.
+ *   In Neurocomputing (under review)
+ *
+ *
+ * Copyright (C) 2016, Visual Information Processing and Learning (VIPL) group,
+ * Institute of Computing Technology, Chinese Academy of Sciences, Beijing, China.
+ *
+ * The codes are mainly developed by Shuzhe Wu (a Ph.D supervised by Prof. Shiguang Shan)
+ *
+ * As an open-source face recognition engine: you can redistribute SeetaFace source codes
+ * and/or modify it under the terms of the BSD 2-Clause License.
+ *
+ * You should have received a copy of the BSD 2-Clause License along with the software.
+ * If not, see < https://opensource.org/licenses/BSD-2-Clause>.
+ *
+ * Contact Info: you can send an email to SeetaFace@vipl.ict.ac.cn for any problems.
+ *
+ * Note: the above information must be kept whenever or wherever the codes are used.
+ *
+ */
+
+
+
+/*
+ * Built with AVX-512 enabled. As for the AVX2 kernels, only headers of
+ * intrinsics and plain declarations may be included here.
+ */
+
+#include "util/simd_kernels.h"
+
+#ifdef USE_AVX512
+
+#include <immintrin.h>
+
+namespace seeta {
+namespace fd {
+
+static inline int32_t CountBits(uint32_t x) {
+  int32_t n = 0;
+  for (; x != 0; x &= x - 1)
+    n++;
+  return n;
+}
+
+static void LABCodeRow(const int32_t* white, const int32_t* black,
+    const int32_t* black_offset, uint8_t* dest, int32_t len) {
+  int32_t c = 0;
+  for (; c + 16 <= len; c += 16) {
+    __m512i white_sum = _mm512_loadu_si512(white + c);
+    __m512i code = _mm512_setzero_si512();
+    for (int32_t i = 0; i < 8; i++) {
+      __mmask16 ge = _mm512_cmpge_epi32_mask(white_sum,
+        _mm512_loadu_si512(black + c + black_offset[i]));
+      code = _mm512_mask_or_epi32(code, ge, code,
+        _mm512_set1_epi32(kLABCodeBit[i]));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + c),
+      _mm512_cvtepi32_epi8(code));
+  }
+  for (; c < len; c++) {
+    uint8_t code = 0;
+    for (int32_t i = 0; i < 8; i++) {
+      if (white[c] >= black[c + black_offset[i]])
+        code |= static_cast<uint8_t>(kLABCodeBit[i]);
+    }
+    dest[c] = code;
+  }
+}
+
+static inline __m512 GatherWeight16(const float* weights, __m512i idx) {
+  return _mm512_i32gather_ps(idx, weights, 4);
+}
+
+static inline __m512 GatherWeight16(const int16_t* weights, __m512i idx) {
+  __m512i w = _mm512_i32gather_epi32(idx, weights, 2);
+  return _mm512_cvtepi32_ps(_mm512_srai_epi32(_mm512_slli_epi32(w, 16), 16));
+}
+
+/** 16 windows at a time in lockstep, then the rest one by one */
+template<typename WeightType>
+static int32_t LABClassifyGroup(const uint8_t* feat_val,
+    const int32_t* wnd_offset, const int32_t* feat_offset, int32_t num_feat,
+    const WeightType* weights, int32_t weight_stride, float thresh,
+    int32_t num_alive, int32_t* wnd_idx, float* wnd_score) {
+  const __m512i mask = _mm512_set1_epi32(0xFF);
+  int32_t num_pos = 0;
+  int32_t k = 0;
+
+  // Survivors are written back in place: `num_pos` never passes `k`
+  for (; k + 16 <= num_alive; k += 16) {
+    __m512i idx = _mm512_loadu_si512(wnd_idx + k);
+    __m512i base = _mm512_i32gather_epi32(idx, wnd_offset, 4);
+    __m512 s = _mm512_loadu_ps(wnd_score + k);
+    for (int32_t j = 0; j < num_feat; j++) {
+      __m512i addr = _mm512_add_epi32(base, _mm512_set1_epi32(feat_offset[j]));
+      __m512i val = _mm512_and_si512(
+        _mm512_i32gather_epi32(addr, feat_val, 1), mask);
+      s = _mm512_add_ps(s, GatherWeight16(weights,
+        _mm512_add_epi32(val, _mm512_set1_epi32(j * weight_stride))));
+    }
+    __mmask16 pos = _mm512_cmp_ps_mask(s, _mm512_set1_ps(thresh),
+      _CMP_NLT_UQ);
+    _mm512_mask_compressstoreu_epi32(wnd_idx + num_pos, pos, idx);
+    _mm512_mask_compressstoreu_ps(wnd_score + num_pos, pos, s);
+    num_pos += CountBits(pos);
+  }
+  for (; k < num_alive; k++) {
+    const uint8_t* wnd_feat_val = feat_val + wnd_offset[wnd_idx[k]];
+    float s = wnd_score[k];
+    for (int32_t j = 0; j < num_feat; j++) {
+      uint8_t val = wnd_feat_val[feat_offset[j]];
+      s += static_cast<float>(weights[j * weight_stride + val]);
+    }
+    if (!(s < thresh)) {
+      wnd_idx[num_pos] = wnd_idx[k];
+      wnd_score[num_pos] = s;
+      num_pos++;
+    }
+  }
+  return num_pos;
+}
+
+void BindAVX512Kernels(SIMDKernels* kernels) {
+  kernels->isa = "avx512";
+  kernels->lab_code_row = LABCodeRow;
+  kernels->lab_classify_group = LABClassifyGroup<float>;
+  kernels->lab_classify_group_int16 = LABClassifyGroup<int16_t>;
+}
+
+}  // namespace fd
+}  // namespace seeta
+
+#endif  // USE_AVX512
@@ -0,0 +1,163 @@
+/*
+ *
+ * This file is part of the open-source SeetaFace engine, which includes three modules:
+ * SeetaFace Detection, SeetaFace Alignment, and SeetaFace Identification.
+ *
+ * This file is part of the SeetaFace Detection module, containing codes implementing the
+ * face detection method described in the following paper:
+ *
+ *
+ *   Funnel-structured cascade for multi-view face detection with alignment awareness,
+ *   Shuzhe Wu, Meina Kan, Zhenliang He, Shiguang Shan, Xilin Chen.
+ *   In Neurocomputing (under review)
+ *
+ *
+ * Copyright (C) 2016, Visual Information Processing and Learning (VIPL) group,
+ * Institute of Computing Technology, Chinese Academy of Sciences, Beijing, China.
+ *
+ * The codes are mainly developed by Shuzhe Wu (a Ph.D supervised by Prof. Shiguang Shan)
+ *
+ * As an open-source face recognition engine: you can redistribute SeetaFace source codes
+ * and/or modify it under the terms of the BSD 2-Clause License.
+ *
+ * You should have received a copy of the BSD 2-Clause License along with the software.
+ * If not, see < https://opensource.org/licenses/BSD-2-Clause>.
+ *
+ * Contact Info: you can send an email to SeetaFace@vipl.ict.ac.cn for any problems.
+ *
+ * Note: the above information must be kept whenever or wherever the codes are used.
+ *
+ */
+
+
+#include "util/thread_pool.h"
+
+namespace seeta {
+namespace fd {
+
+// Pool and index of the worker running on this thread, if any
+static thread_local const ThreadPool* current_pool = nullptr;
+static thread_local int32_t current_worker = -1;
+
+ThreadPool::ThreadPool(int32_t num_threads)
+    : num_queued_(0), next_worker_(0), stop_(false) {
+  if (num_threads < 1)
+    num_threads = 1;
+  for (int32_t i = 0; i < num_threads; i++)
+    workers_.push_back(std::unique_ptr<Worker>(new Worker()));
+  for (int32_t i = 0; i < num_threads; i++)
+    threads_.push_back(std::thread(&ThreadPool::WorkerLoop, this, i));
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (size_t i = 0; i < threads_.size(); i++)
+    threads_[i].join();
+}
+
+void ThreadPool::Run(const std::vector<Task> & tasks) {
+  if (tasks.empty())
+    return;
+
+  Batch batch;
+  batch.num_pending = static_cast<int32_t>(tasks.size());
+
+  int32_t worker_id;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    worker_id = next_worker_;
+    next_worker_ = (next_worker_ + 1) % num_threads();
+  }
+  for (size_t i = 0; i < tasks.size(); i++) {
+    Job job;
+    job.task = tasks[i];
+    job.batch = &batch;
+    Push(worker_id, job);
+    worker_id = (worker_id + 1) % num_threads();
+  }
+
+  // Called from a task: run queued jobs until the rest of the batch has been
+  // taken by other workers, which then finish it without waiting on us
+  if (current_pool == this) {
+    Job job;
+    while (batch.num_pending > 0 && Pop(current_worker, &job))
+      RunJob(&job);
+  }
+
+  std::unique_lock<std::mutex> lock(batch.mutex);
+  batch.done.wait(lock, [&batch] { return batch.num_pending == 0; });
+}
+
+void ThreadPool::Push(int32_t worker_id, const Job & job) {
+  {
+    std::lock_guard<std::mutex> lock(workers_[worker_id]->mutex);
+    workers_[worker_id]->jobs.push_back(job);
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    num_queued_++;
+  }
+  wake_.notify_one();
+}
+
+bool ThreadPool::Pop(int32_t worker_id, Job* job) {
+  int32_t num_workers = num_threads();
+  bool found = false;
+
+  for (int32_t i = 0; !found && i < num_workers; i++) {
+    Worker* worker = workers_[(worker_id + i) % num_workers].get();
+    std::lock_guard<std::mutex> lock(worker->mutex);
+    if (!worker->jobs.empty()) {
+      if (i == 0) {
+        *job = worker->jobs.front();
+        worker->jobs.pop_front();
+      } else {
+        *job = worker->jobs.back();
+        worker->jobs.pop_back();
+      }
+      found = true;
+    }
+  }
+
+  if (found) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    num_queued_--;
+  }
+  return found;
+}
+
+void ThreadPool::RunJob(Job* job) {
+  Batch* batch = job->batch;
+  job->task();
+  *job = Job();
+
+  // Notify under the lock: `Run()` may return and free the batch as soon
+  // as it sees no pending task.
+  std::lock_guard<std::mutex> lock(batch->mutex);
+  if (--(batch->num_pending) == 0)
+    batch->done.notify_all();
+}
+
+void ThreadPool::WorkerLoop(int32_t worker_id) {
+  current_pool = this;
+  current_worker = worker_id;
+
+  Job job;
+  while (true) {
+    if (!Pop(worker_id, &job)) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [this] { return stop_ || num_queued_ > 0; });
+      if (stop_ && num_queued_ == 0)
+        return;
+      continue;
+    }
+    RunJob(&job);
+  }
+}
+
+}  // namespace fd
+}  // namespace seeta
@@ -32,14 +32,24 @@
 #include "math_functions.h"
 #include <xmmintrin.h>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
 
 #ifdef _WIN32
 #include <intrin.h>
 #else
 #include <x86intrin.h>
+#include <cpuid.h>
 #endif
 
-float simd_dot(const float* x, const float* y, const long& len) {
+// Variants of simd_dot() built with USE_AVX2 (with FMA) and USE_AVX512, in
+// files of their own compiled for those instruction sets.
+float simd_dot_avx2(const float* x, const float* y, const long& len);
+float simd_dot_avx512(const float* x, const float* y, const long& len);
+
+typedef float (*DotFunction)(const float* x, const float* y, const long& len);
+
+static float simd_dot_sse(const float* x, const float* y, const long& len) {
   float inner_prod = 0.0f;
   __m128 X, Y; // 128-bit values
   __m128 acc = _mm_setzero_ps(); // set to (0, 0, 0, 0)
@@ -61,6 +71,73 @@ float simd_dot(const float* x, const float* y, const long& len) {
   return inner_prod;
 }
 
+static void cpuid(uint32_t leaf, uint32_t* regs) {
+#ifdef _WIN32
+  int info[4];
+  __cpuidex(info, leaf, 0);
+  for (int i = 0; i < 4; ++i)
+    regs[i] = static_cast<uint32_t>(info[i]);
+#else
+  if (!__get_cpuid_count(leaf, 0, &regs[0], &regs[1], &regs[2], &regs[3]))
+    regs[0] = regs[1] = regs[2] = regs[3] = 0;
+#endif
+}
+
+static uint64_t xgetbv() {
+#ifdef _WIN32
+  return _xgetbv(0);
+#else
+  uint32_t eax, edx;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+// The fastest simd_dot() variant the CPU and OS support. As in SeetaFace
+// Detection, the environment variable SEETA_CPU_MAX_ISA ("sse4.1", "avx2" or
+// "avx512") caps the instruction sets used.
+static DotFunction select_dot() {
+  DotFunction dot = simd_dot_sse;
+  uint32_t regs[4];
+  cpuid(0, regs);
+  uint32_t max_leaf = regs[0];
+  if (max_leaf < 7)
+    return dot;
+  cpuid(1, regs);
+  bool has_fma = (regs[2] & (1u << 12)) != 0;
+  bool has_xsave = (regs[2] & (1u << 27)) != 0;
+  bool has_avx = (regs[2] & (1u << 28)) != 0;
+  if (!has_xsave || !has_avx)
+    return dot;
+  uint64_t xcr0 = xgetbv();
+  cpuid(7, regs);
+  bool has_avx2 = (xcr0 & 0x6) == 0x6 && has_fma &&
+    (regs[1] & (1u << 5)) != 0;
+  bool has_avx512 = (xcr0 & 0xE6) == 0xE6 && (regs[1] & (1u << 16)) != 0;
+
+  const char* max_isa = getenv("SEETA_CPU_MAX_ISA");
+  if (max_isa != NULL) {
+    if (strcmp(max_isa, "avx512") != 0)
+      has_avx512 = false;
+    if (strcmp(max_isa, "avx512") != 0 && strcmp(max_isa, "avx2") != 0)
+      has_avx2 = false;
+  }
+#ifdef USE_AVX2
+  if (has_avx2)
+    dot = simd_dot_avx2;
+#endif
+#ifdef USE_AVX512
+  if (has_avx512)
+    dot = simd_dot_avx512;
+#endif
+  return dot;
+}
+
+float simd_dot(const float* x, const float* y, const long& len) {
+  static const DotFunction dot = select_dot();
+  return dot(x, y, len);
+}
+
 void matrix_procuct(const float* A, const float* B, float* C, const int n,
     const int m, const int k, bool ta, bool tb) {
 #ifdef _BLAS
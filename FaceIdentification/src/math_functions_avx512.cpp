@@ -0,0 +1,63 @@
+/*
+ *
+ * This file is part of the open-source SeetaFace engine, which includes three modules:
+ * SeetaFace Detection, SeetaFace Alignment, and SeetaFace Identification.
+ *
+ * This file is part of the SeetaFace Identification module, containing codes implementing the
+ * face identification method described in the following paper:
+ *
+ *   
+ *   VIPLFaceNet: An Open Source Deep Face Recognition SDK,
+ *   Xin Liu, Meina Kan, Wanglong Wu, Shiguang Shan, Xilin Chen.
+ *   In Frontiers of Computer Science.
+ *
+ *
+ * Copyright (C) 2016, Visual Information Processing and Learning (VIPL) group,
+ * Institute of Computing Technology, Chinese Academy of Sciences, Beijing, China.
+ *
+ * The codes are mainly developed by Zining Xu(a M.S. supervised by Prof. Shiguang Shan)
+ *
+ * As an open-source face recognition engine: you can redistribute SeetaFace source codes
+ * and/or modify it under the terms of the BSD 2-Clause License.
+ *
+ * You should have received a copy of the BSD 2-Clause License along with the software.
+ * If not, see < https://opensource.org/licenses/BSD-2-Clause>.
+ *
+ * Contact Info: you can send an email to SeetaFace@vipl.ict.ac.cn for any problems. 
+ *
+ * Note: the above information must be kept whenever or wherever the codes are used.
+ *
+ */
+
+// simd_dot() for CPUs with AVX-512, built with -mavx512f. As for the AVX2
+// variant, only the intrinsics header is included.
+
+#ifdef USE_AVX512
+
+#include <immintrin.h>
+
+float simd_dot_avx512(const float* x, const float* y, const long& len) {
+  __m512 acc0 = _mm512_setzero_ps();
+  __m512 acc1 = _mm512_setzero_ps();
+
+  long i;
+  for (i = 0; i + 32 <= len; i += 32) {
+    acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i),
+      acc0);
+    acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i + 16),
+      _mm512_loadu_ps(y + i + 16), acc1);
+  }
+  for (; i + 16 <= len; i += 16) {
+    acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i),
+      acc0);
+  }
+  float inner_prod = _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+
+  // add the remaining values
+  for (; i < len; ++i) {
+    inner_prod += x[i] * y[i];
+  }
+  return inner_prod;
+}
+
+#endif  // USE_AVX512